@@ -2,13 +2,16 @@
 #define ALGORITHMS_BASIC_H
 
 #include <set>
+#include <deque>
 #include <vector>
 #include <limits>
+#include <cassert>
 #include <algorithm>
 
 #include "topology.h"
 #include "weight.h"
 #include "config.h"
+#include "instrumentation.h"
 
 // Fundamental algorithms.
 // =======================
@@ -48,7 +51,6 @@ typename Metric::weight_type accumulate_weight(const Metric& m, const Topology&
 template <class Metric, class Topology>
 double accumulate_cost(const Metric& m, const Topology& t)
 {
-    double result = 0;
     return accumulate_edge(t, 0.0, [&m](double cost, const edge& e) { return cost + m(e)[0]; });
 }
 
@@ -80,9 +82,14 @@ node max_node(const Topology& t)
 // Topological structure building algorithms.
 // ==========================================
 
+/// The path from src to dst along the predecessors' map; empty if dst is
+/// not reached, i.e. if it is its own predecessor.
 template <class PredMap>
 path build_path(node src, node dst, const PredMap& pm) {
     path result;
+    if (dst != src && pm[dst] == dst) {
+        return result;
+    }
     node u = dst;
     while (u != src) {
         result.push_front(u);
@@ -92,6 +99,20 @@ path build_path(node src, node dst, const PredMap& pm) {
     return result;
 }
 
+template <class PredMap>
+void build_path(node src, node dst, const PredMap& pm, path& out) {
+    out.clear();
+    if (dst != src && pm[dst] == dst) {
+        return;
+    }
+    node u = dst;
+    while (u != src) {
+        out.push_front(u);
+        u = pm[u];
+    }
+    out.push_front(src);
+}
+
 template <class PredMap>
 tree build_tree(const PredMap& pm) {
     tree result;
@@ -108,8 +129,176 @@ tree build_tree(const PredMap& pm) {
 // Tological optimization algorithms.
 // ==================================
 
+/// The state of a single source search that may be reused between
+/// subsequent searches over the same topology in order to avoid the
+/// repeated allocations. After a search the predecessors' and distances'
+/// maps remain available for inspection.
+///
+/// The workspace is to be sized for all the nodes of the topology, i.e. up
+/// to max_node(t), before a search; a default-constructed one is empty. The
+/// searches assert the size.
+///
+/// @tparam W The weight type of the search.
+template <Weight W>
+struct search_workspace {
+
+    using entry = std::pair<W, node>;
+
+    std::vector<node> preds;
+    std::vector<W> dists;
+    std::vector<entry> open;
+
+    search_workspace() = default;
+    explicit search_workspace(node count) { resize(count); }
+
+    void resize(node count)
+    {
+        preds.resize(count);
+        dists.resize(count);
+        open.reserve(count);
+    }
+
+    void reset(node src)
+    {
+        assert(src >= 0 && src < static_cast<node>(preds.size()));
+        for (node n = 0; n < static_cast<node>(preds.size()); ++n) {
+            preds[n] = n;
+        }
+        std::fill(begin(dists), end(dists), weight_traits<W>::inf());
+        dists[src] = weight_traits<W>::zero();
+        open.clear();
+    }
+
+    bool reached(node src, node dst) const
+    {
+        assert(dst >= 0 && dst < static_cast<node>(preds.size()));
+        return dst == src || preds[dst] != dst;
+    }
+
+    /// The owned memory; the frontier only holds the entries of the last
+    /// search, its remaining reserved capacity is slack.
+    friend memory_footprint memory_usage(const search_workspace& ws)
+    {
+        return detail::vector_footprint(ws.preds) +
+            detail::vector_footprint(ws.dists) +
+            detail::vector_footprint(ws.open);
+    }
+};
+
 namespace detail {
 
+    /// The disjoint sets forest (union-find) with path compression and
+    /// union by rank.
+    class disjoint_sets {
+
+        std::vector<node> m_parent;
+        std::vector<int> m_rank;
+
+    public:
+        disjoint_sets() = default;
+
+        explicit disjoint_sets(node count)
+        {
+            grow(count);
+        }
+
+        /// Adds the singleton sets of the nodes up to count.
+        void grow(node count)
+        {
+            for (node n = size(); n < count; ++n) {
+                m_parent.push_back(n);
+                m_rank.push_back(0);
+            }
+        }
+
+        /// The representative of the set of x, without the path compression,
+        /// so that the structure may be read by many threads at once.
+        node root(node x) const
+        {
+            while (m_parent[x] != x) {
+                x = m_parent[x];
+            }
+            return x;
+        }
+
+        node find(node x)
+        {
+            node root = x;
+            while (m_parent[root] != root) {
+                root = m_parent[root];
+            }
+            while (m_parent[x] != root) {
+                node next = m_parent[x];
+                m_parent[x] = root;
+                x = next;
+            }
+            return root;
+        }
+
+        /// Merges the sets of x and y; returns false if they were already
+        /// the same set.
+        bool unite(node x, node y)
+        {
+            x = find(x);
+            y = find(y);
+            if (x == y) {
+                return false;
+            }
+            if (m_rank[x] < m_rank[y]) {
+                std::swap(x, y);
+            }
+            m_parent[y] = x;
+            if (m_rank[x] == m_rank[y]) {
+                ++m_rank[x];
+            }
+            return true;
+        }
+
+        node size() const { return m_parent.size(); }
+
+        friend memory_footprint memory_usage(const disjoint_sets& x)
+        {
+            return detail::vector_footprint(x.m_parent) + detail::vector_footprint(x.m_rank);
+        }
+    };
+
+    /// Turns an undirected forest given as a list of edges into
+    /// a predecessors' map. Each tree is rooted in its lowest node.
+    inline void orient_forest(node count, const std::vector<edge>& edges, std::vector<node>& out_preds)
+    {
+        std::vector<std::vector<node>> adjacency(count);
+        for (const edge& e : edges) {
+            adjacency[e.first].push_back(e.second);
+            adjacency[e.second].push_back(e.first);
+        }
+
+        out_preds.clear();
+        for (node n = 0; n < count; ++n) {
+            out_preds.push_back(n);
+        }
+
+        std::vector<bool> visited(count, false);
+        std::deque<node> queue;
+        for (node root = 0; root < count; ++root) {
+            if (visited[root]) {
+                continue;
+            }
+            visited[root] = true;
+            queue.push_back(root);
+            while (!queue.empty()) {
+                node u = queue.front();
+                queue.pop_front();
+                for (node v : adjacency[u]) {
+                    if (!visited[v]) {
+                        visited[v] = true;
+                        out_preds[v] = u;
+                        queue.push_back(v);
+                    }
+                }
+            }
+        }
+    }
+
     // Stop conditions for the Dijkstra's algorithm implementation.
     // ------------------------------------------------------------
 
@@ -128,46 +317,64 @@ namespace detail {
     /// @tparam Metric A metric,
     /// @tparam Stop A functor defining the stop condition for the algorithm.
     /// @tparam WeightCmp A functor providing the means of comparing weights.
+    /// @tparam Stats A SearchStats instrumentation policy.
     ///
     /// @param t The topology,
     /// @param m The metric,
     /// @param src The source for the relaxation,
-    /// @param out_preds The out parameter returning the predecessors' map,
-    /// @param out_dists The out parameter returning the distances' map.
+    /// @param ws The workspace; holds the predecessors' and distances' maps
+    ///           after the call,
     /// @param stop The stop condition functor,
     /// @param cmp The weight comparator functor,
+    /// @param stats The instrumentation receiving the search events.
     ///
-    template <class Topology, class Metric, typename Stop, typename WeightCmp>
+    template <class Topology, class Metric, typename Stop, typename WeightCmp, class Stats>
     void dijkstra_relax(
             const Topology& t,
             const Metric& m,
             node src,
-            std::vector<node>& out_preds,
-            std::vector<typename Metric::weight_type>& out_dists,
+            search_workspace<typename Metric::weight_type>& ws,
             Stop stop,
-            const WeightCmp& cmp) {
+            const WeightCmp& cmp,
+            Stats& stats) {
 
-        const node mn = max_node(t);
+        using W = typename Metric::weight_type;
+        using entry = typename search_workspace<W>::entry;
 
-        out_preds.clear();
-        out_dists.clear();
-        for (node n = 0; n <= mn; ++n) {
-            out_dists.push_back(weight_traits<typename Metric::weight_type>::inf());
-            out_preds.push_back(n);
-        }
-        out_dists[src] = weight_traits<typename Metric::weight_type>::zero();
+        ws.reset(src);
 
-        std::set<node> open;
-        open.insert(src);
+        // The heap is a max-heap in terms of this order, hence the inversion.
+        // Ties are settled in the order of the node identifiers.
+        auto heap_cmp = [&cmp, &stats](const entry& x, const entry& y) {
+            stats.compared();
+            if (cmp(y.first, x.first)) return true;
+            stats.compared();
+            if (cmp(x.first, y.first)) return false;
+            return y.second < x.second;
+        };
+
+        auto& dists = ws.dists;
+        auto& preds = ws.preds;
+        auto& open = ws.open;
+
+        open.emplace_back(dists[src], src);
+        stats.pushed();
 
         while (!open.empty()) {
 
-            auto it = std::min_element(begin(open), end(open),
-                [&out_dists, &cmp](node x, node y) {
-                    return cmp(out_dists[x], out_dists[y]);
-                });
+            std::pop_heap(begin(open), end(open), heap_cmp);
+            const entry top = open.back();
+            open.pop_back();
+            stats.popped();
 
-            node u = *it;
+            node u = top.second;
+            stats.compared();
+            if (cmp(dists[u], top.first)) {
+                // Stale entry; the node has been improved since.
+                continue;
+            }
+
+            stats.settled();
             if (stop(u)) {
                 break;
             }
@@ -175,24 +382,60 @@ namespace detail {
             std::for_each(
                 out_begin(t, u),
                 out_end(t, u),
-                [u, &out_dists, &out_preds, &m, &open, &cmp](node v) {
-                    typename Metric::weight_type new_dist = out_dists[u] + m(edge(u, v));
-                    if (cmp(new_dist, out_dists[v])) {
-                        out_dists[v] = new_dist;
-                        out_preds[v] = u;
-                        open.insert(v);
+                [u, &dists, &preds, &m, &open, &cmp, &heap_cmp, &stats](node v) {
+                    assert(v < static_cast<node>(dists.size()));
+                    stats.relaxed();
+                    stats.looked_up();
+                    W new_dist = dists[u] + m(edge(u, v));
+                    stats.compared();
+                    if (cmp(new_dist, dists[v])) {
+                        stats.improved();
+                        dists[v] = new_dist;
+                        preds[v] = u;
+                        open.emplace_back(new_dist, v);
+                        std::push_heap(begin(open), end(open), heap_cmp);
+                        stats.pushed();
                     }
                 });
-
-            open.erase(u);
         }
     }
 
+    /// Dijkstra's algorithm without instrumentation.
+    template <class Topology, class Metric, typename Stop, typename WeightCmp>
+    void dijkstra_relax(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            search_workspace<typename Metric::weight_type>& ws,
+            Stop stop,
+            const WeightCmp& cmp) {
+        no_stats stats;
+        dijkstra_relax(t, m, src, ws, stop, cmp, stats);
+    }
+
+    /// Dijkstra's algorithm returning the search result in the vectors.
+    template <class Topology, class Metric, typename Stop, typename WeightCmp>
+    void dijkstra_relax(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            std::vector<node>& out_preds,
+            std::vector<typename Metric::weight_type>& out_dists,
+            Stop stop,
+            const WeightCmp& cmp) {
+
+        search_workspace<typename Metric::weight_type> ws { max_node(t) + 1 };
+        dijkstra_relax(t, m, src, ws, stop, cmp);
+        out_preds = std::move(ws.preds);
+        out_dists = std::move(ws.dists);
+    }
+
     /// The Bellman-Ford relaxation raw implementation.
     ///
     /// @tparam Topology A topology,
     /// @tparam Metric A metric,
     /// @tparam WeightCmp A functor providing the means of comparing weights.
+    /// @tparam Stats A SearchStats instrumentation policy.
     ///
     /// @param t The topology,
     /// @param m The metric,
@@ -200,14 +443,16 @@ namespace detail {
     /// @param out_preds The out parameter returning the predecessors' map,
     /// @param out_dists The out parameter returning the distances' map.
     /// @param cmp The weight comparator functor,
-    template <class Topology, class Metric, typename WeightCmp>
+    /// @param stats The instrumentation receiving the search events.
+    template <class Topology, class Metric, typename WeightCmp, class Stats>
     void bellman_ford_relax(
             const Topology& t,
             const Metric& m,
             node src,
             std::vector<node>& out_preds,
             std::vector<typename Metric::weight_type>& out_dists,
-            const WeightCmp& cmp) {
+            const WeightCmp& cmp,
+            Stats& stats) {
 
         const node mn = max_node(t);
         const node N = nodes_count(t);
@@ -224,11 +469,15 @@ namespace detail {
             std::for_each(
                 edge_begin(t),
                 edge_end(t),
-                [&out_dists, &out_preds, &m, &cmp] (edge e) {
+                [&out_dists, &out_preds, &m, &cmp, &stats] (edge e) {
                     node u = e.first;
                     node v = e.second;
+                    stats.relaxed();
+                    stats.looked_up();
                     typename Metric::weight_type new_dist = out_dists[u] + m(edge(u, v));
+                    stats.compared();
                     if (cmp(new_dist, out_dists[v])) {
+                        stats.improved();
                         out_dists[v] = new_dist;
                         out_preds[v] = u;
                     }
@@ -236,6 +485,128 @@ namespace detail {
         }
     }
 
+    /// The Bellman-Ford relaxation without instrumentation.
+    template <class Topology, class Metric, typename WeightCmp>
+    void bellman_ford_relax(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            std::vector<node>& out_preds,
+            std::vector<typename Metric::weight_type>& out_dists,
+            const WeightCmp& cmp) {
+        no_stats stats;
+        bellman_ford_relax(t, m, src, out_preds, out_dists, cmp, stats);
+    }
+
+
+    /// Prim's minimum spanning tree algorithm with a binary heap.
+    /// The edges are treated as undirected, i.e. the topology is expected
+    /// to be symmetric. Only the component of the source is spanned.
+    ///
+    /// @tparam Topology A topology,
+    /// @tparam Metric A metric,
+    /// @tparam WeightCmp A functor providing the means of comparing weights.
+    ///
+    /// @param t The topology,
+    /// @param m The metric,
+    /// @param src The root of the resulting tree,
+    /// @param out_preds The out parameter returning the predecessors' map,
+    /// @param cmp The weight comparator functor,
+    template <class Topology, class Metric, typename WeightCmp>
+    void prim_relax(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            std::vector<node>& out_preds,
+            const WeightCmp& cmp) {
+
+        using W = typename Metric::weight_type;
+        using entry = std::pair<W, node>;
+
+        const node mn = max_node(t);
+
+        out_preds.clear();
+        std::vector<W> keys;
+        for (node n = 0; n <= mn; ++n) {
+            keys.push_back(weight_traits<W>::inf());
+            out_preds.push_back(n);
+        }
+        std::vector<bool> in_tree(mn + 1, false);
+        keys[src] = weight_traits<W>::zero();
+
+        // The heap is a max-heap in terms of this order, hence the inversion.
+        auto heap_cmp = [&cmp](const entry& x, const entry& y) {
+            if (cmp(y.first, x.first)) return true;
+            if (cmp(x.first, y.first)) return false;
+            return y.second < x.second;
+        };
+
+        std::vector<entry> heap { { keys[src], src } };
+        while (!heap.empty()) {
+
+            std::pop_heap(begin(heap), end(heap), heap_cmp);
+            node u = heap.back().second;
+            heap.pop_back();
+
+            if (in_tree[u]) {
+                continue;
+            }
+            in_tree[u] = true;
+
+            std::for_each(out_begin(t, u), out_end(t, u), [&](node v) {
+                if (in_tree[v]) {
+                    return;
+                }
+                const W& w = m(edge(u, v));
+                if (cmp(w, keys[v])) {
+                    keys[v] = w;
+                    out_preds[v] = u;
+                    heap.emplace_back(w, v);
+                    std::push_heap(begin(heap), end(heap), heap_cmp);
+                }
+            });
+        }
+    }
+
+    /// Kruskal's minimum spanning forest algorithm: the edges are sorted by
+    /// weight and accepted unless they close a cycle, which is detected with
+    /// the disjoint sets forest.
+    ///
+    /// @param t The topology,
+    /// @param m The metric,
+    /// @param out_edges The out parameter returning the edges of the forest,
+    /// @param cmp The weight comparator functor,
+    template <class Topology, class Metric, typename WeightCmp>
+    void kruskal_select(
+            const Topology& t,
+            const Metric& m,
+            std::vector<edge>& out_edges,
+            const WeightCmp& cmp) {
+
+        using W = typename Metric::weight_type;
+
+        std::vector<std::pair<W, edge>> edges;
+        std::for_each(edge_begin(t), edge_end(t), [&edges, &m](const edge& e) {
+            edges.emplace_back(m(e), e);
+        });
+
+        std::sort(begin(edges), end(edges),
+            [&cmp](const std::pair<W, edge>& x, const std::pair<W, edge>& y) {
+                if (cmp(x.first, y.first)) return true;
+                if (cmp(y.first, x.first)) return false;
+                return normalize(x.second) < normalize(y.second);
+            });
+
+        disjoint_sets sets { max_node(t) + 1 };
+
+        out_edges.clear();
+        for (const auto& pr : edges) {
+            if (sets.unite(pr.second.first, pr.second.second)) {
+                out_edges.push_back(pr.second);
+            }
+        }
+    }
+
 }
 
 // The convenient API for the topological optimization algorithms.
@@ -243,26 +614,105 @@ namespace detail {
 
 template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
 path dijkstra(const Topology& t, const Metric& m, node src, node dst, const WeightCmp& cmp = WeightCmp {}) {
+    if (known_unreachable(t, src, dst)) {
+        return {};
+    }
     std::vector<node> preds;
     std::vector<typename Metric::weight_type> dists;
     detail::dijkstra_relax(t, m, src, preds, dists, detail::dst_stop{ dst }, cmp);
     return build_path(src, dst, preds);
 }
 
+/// Dijkstra's algorithm reusing the given workspace. The path is stored
+/// in out_path, which is left empty if dst is unreachable. If the topology
+/// knows that dst is unreachable, no search is run and the workspace is left
+/// as it is.
+///
+/// @return The accumulated weight of the path, i.e. the distance of dst.
 template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
-tree prim(const Topology& t, const Metric& m, node src, const WeightCmp& cmp = WeightCmp {}) {
+typename Metric::weight_type dijkstra(
+        const Topology& t, const Metric& m, node src, node dst,
+        search_workspace<typename Metric::weight_type>& ws, path& out_path,
+        const WeightCmp& cmp = WeightCmp {}) {
+    if (known_unreachable(t, src, dst)) {
+        out_path.clear();
+        return weight_traits<typename Metric::weight_type>::inf();
+    }
+    detail::dijkstra_relax(t, m, src, ws, detail::dst_stop{ dst }, cmp);
+    if (!ws.reached(src, dst)) {
+        out_path.clear();
+    } else {
+        build_path(src, dst, ws.preds, out_path);
+    }
+    return ws.dists[dst];
+}
+
+/// Dijkstra's algorithm reusing the given workspace and reporting the search
+/// events to the given instrumentation.
+template <class Topology, class Metric, typename WeightCmp, class Stats>
+typename Metric::weight_type dijkstra(
+        const Topology& t, const Metric& m, node src, node dst,
+        search_workspace<typename Metric::weight_type>& ws, path& out_path,
+        const WeightCmp& cmp, Stats& stats) {
+    if (known_unreachable(t, src, dst)) {
+        out_path.clear();
+        return weight_traits<typename Metric::weight_type>::inf();
+    }
+    detail::dijkstra_relax(t, m, src, ws, detail::dst_stop{ dst }, cmp, stats);
+    if (!ws.reached(src, dst)) {
+        out_path.clear();
+    } else {
+        build_path(src, dst, ws.preds, out_path);
+    }
+    return ws.dists[dst];
+}
+
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+tree shortest_path_tree(const Topology& t, const Metric& m, node src, const WeightCmp& cmp = WeightCmp {}) {
     std::vector<node> preds;
     std::vector<typename Metric::weight_type> dists;
     detail::dijkstra_relax(t, m, src, preds, dists, detail::never_stop{}, cmp);
     return build_tree(preds);
 }
 
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+tree prim(const Topology& t, const Metric& m, node src, const WeightCmp& cmp = WeightCmp {}) {
+    std::vector<node> preds;
+    detail::prim_relax(t, m, src, preds, cmp);
+    return build_tree(preds);
+}
+
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+tree kruskal(const Topology& t, const Metric& m, const WeightCmp& cmp = WeightCmp {}) {
+    std::vector<edge> edges;
+    detail::kruskal_select(t, m, edges, cmp);
+    std::vector<node> preds;
+    detail::orient_forest(max_node(t) + 1, edges, preds);
+    return build_tree(preds);
+}
+
 template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
 path bellman_ford(const Topology& t, const Metric& m, node src, node dst, const WeightCmp& cmp = WeightCmp {}) {
+    if (known_unreachable(t, src, dst)) {
+        return {};
+    }
     std::vector<node> preds;
     std::vector<typename Metric::weight_type> dists;
     detail::bellman_ford_relax(t, m, src, preds, dists, cmp);
     return build_path(src, dst, preds);
 }
 
+/// The Bellman-Ford algorithm reporting the relaxation events to the given
+/// instrumentation.
+template <class Topology, class Metric, typename WeightCmp, class Stats>
+path bellman_ford(const Topology& t, const Metric& m, node src, node dst, const WeightCmp& cmp, Stats& stats) {
+    if (known_unreachable(t, src, dst)) {
+        return {};
+    }
+    std::vector<node> preds;
+    std::vector<typename Metric::weight_type> dists;
+    detail::bellman_ford_relax(t, m, src, preds, dists, cmp, stats);
+    return build_path(src, dst, preds);
+}
+
 #endif
@@ -0,0 +1,188 @@
+#ifndef ALGORITHMS_CACHE_H
+#define ALGORITHMS_CACHE_H
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <tuple>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <typeindex>
+
+#include "algorithms_basic.h"
+
+// The cache of the shortest path trees.
+// =====================================
+
+/// The cache of the full shortest path trees keyed by the source and the
+/// comparator. A point query for a cached pair is answered by walking the
+/// predecessors, i.e. in the time proportional to the path length.
+///
+/// The cache is bounded by the bytes taken by the trees and evicts the least
+/// recently used ones. It is invalidated as a whole whenever the version of
+/// the topology or of the metric changes, so that both are to provide their
+/// version(), the immutable ones a constant. The queries may be issued
+/// concurrently; the trees are immutable once published and are read outside
+/// of the lock.
+///
+/// The comparators are told apart by their types. The comparators of the
+/// same type with different state (e.g. different coefficients) must be
+/// distinguished by an explicit tag.
+template <class Topology, class Metric>
+class spt_cache {
+
+public:
+    using weight_type = typename Metric::weight_type;
+
+    /// A cached shortest path tree.
+    struct entry {
+        std::vector<node> preds;
+        std::vector<weight_type> dists;
+
+        std::size_t bytes() const
+        {
+            return sizeof(entry) +
+                preds.capacity() * sizeof(node) +
+                dists.capacity() * sizeof(weight_type);
+        }
+    };
+
+private:
+    using key = std::tuple<node, std::type_index, std::size_t>;
+    using lru_list = std::list<key>;
+
+    struct slot {
+        std::shared_ptr<const entry> tree;
+        typename lru_list::iterator position;
+    };
+
+    const Topology& m_topology;
+    const Metric& m_metric;
+    const std::size_t m_capacity;
+
+    std::mutex m_guard;
+    std::size_t m_topology_version;
+    std::size_t m_metric_version;
+    std::size_t m_bytes = 0;
+    lru_list m_lru;
+    std::map<key, slot> m_slots;
+
+    std::atomic<std::size_t> m_hits { 0 };
+    std::atomic<std::size_t> m_misses { 0 };
+
+    /// Drops everything if the underlying structures have changed.
+    /// Must be called with the lock held.
+    void validate()
+    {
+        const std::size_t tv = version(m_topology);
+        const std::size_t mv = version(m_metric);
+        if (tv != m_topology_version || mv != m_metric_version) {
+            m_slots.clear();
+            m_lru.clear();
+            m_bytes = 0;
+            m_topology_version = tv;
+            m_metric_version = mv;
+        }
+    }
+
+    /// Must be called with the lock held.
+    void insert(const key& k, std::shared_ptr<const entry> tree)
+    {
+        const std::size_t bytes = tree->bytes();
+        if (bytes > m_capacity || m_slots.count(k)) {
+            return;
+        }
+        while (m_bytes + bytes > m_capacity) {
+            auto victim = m_slots.find(m_lru.back());
+            m_bytes -= victim->second.tree->bytes();
+            m_slots.erase(victim);
+            m_lru.pop_back();
+        }
+        m_lru.push_front(k);
+        m_slots.emplace(k, slot { std::move(tree), m_lru.begin() });
+        m_bytes += bytes;
+    }
+
+public:
+    /// @param t The topology,
+    /// @param m The metric,
+    /// @param capacity The bound of the bytes taken by the cached trees.
+    spt_cache(const Topology& t, const Metric& m, std::size_t capacity) :
+        m_topology { t },
+        m_metric { m },
+        m_capacity { capacity },
+        m_topology_version { version(t) },
+        m_metric_version { version(m) }
+    {}
+
+    /// Finds or computes the shortest path tree of src.
+    template <typename WeightCmp>
+    std::shared_ptr<const entry> tree_of(node src, const WeightCmp& cmp, std::size_t tag = 0)
+    {
+        const key k { src, std::type_index(typeid(WeightCmp)), tag };
+        {
+            std::lock_guard<std::mutex> lock { m_guard };
+            validate();
+            auto found = m_slots.find(k);
+            if (found != end(m_slots)) {
+                m_lru.splice(m_lru.begin(), m_lru, found->second.position);
+                ++m_hits;
+                return found->second.tree;
+            }
+        }
+
+        ++m_misses;
+
+        search_workspace<weight_type> ws { max_node(m_topology) + 1 };
+        detail::dijkstra_relax(m_topology, m_metric, src, ws, detail::never_stop {}, cmp);
+        auto tree = std::make_shared<entry>();
+        tree->preds = std::move(ws.preds);
+        tree->dists = std::move(ws.dists);
+
+        {
+            std::lock_guard<std::mutex> lock { m_guard };
+            validate();
+            insert(k, tree);
+        }
+
+        return tree;
+    }
+
+    /// The shortest path between src and dst; empty if dst is unreachable.
+    template <typename WeightCmp = std::less<weight_type>>
+    path query(node src, node dst, const WeightCmp& cmp = WeightCmp {}, std::size_t tag = 0)
+    {
+        const auto tree = tree_of(src, cmp, tag);
+        if (dst != src && tree->preds[dst] == dst) {
+            return {};
+        }
+        return build_path(src, dst, tree->preds);
+    }
+
+    /// The distance between src and dst.
+    template <typename WeightCmp = std::less<weight_type>>
+    weight_type distance(node src, node dst, const WeightCmp& cmp = WeightCmp {}, std::size_t tag = 0)
+    {
+        return tree_of(src, cmp, tag)->dists[dst];
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock { m_guard };
+        m_slots.clear();
+        m_lru.clear();
+        m_bytes = 0;
+    }
+
+    std::size_t bytes()
+    {
+        std::lock_guard<std::mutex> lock { m_guard };
+        return m_bytes;
+    }
+
+    std::size_t hits() const { return m_hits.load(); }
+    std::size_t misses() const { return m_misses.load(); }
+};
+
+#endif
@@ -0,0 +1,219 @@
+#ifndef ALGORITHMS_DYNAMIC_H
+#define ALGORITHMS_DYNAMIC_H
+
+#include <vector>
+#include <utility>
+
+#include "algorithms_basic.h"
+
+// The dynamic shortest path tree.
+// ===============================
+
+/// The shortest path tree of a single source maintained under the changes
+/// of the edge weights, in the manner of Ramalingam and Reps.
+///
+/// The structure owns the predecessors' and distances' maps. An update
+/// writes the new weights into the metric and then repairs only the part
+/// of the tree affected by them: the subtrees hanging from the changed tree
+/// edges are detached and reattached from their unaffected in-neighbors,
+/// and the improvements through the changed edges are propagated with
+/// a Dijkstra's search seeded by the touched nodes only. The weights must
+/// be nonnegative and the topology must not change.
+///
+/// Of the equally short paths, the tree keeps those a Dijkstra's search
+/// from scratch chooses: the predecessor of a node is the one settled first,
+/// i.e. of the lowest distance and then of the lowest identifier, so that
+/// the tree stays the same for the positive weights.
+///
+/// @tparam Topology A topology,
+/// @tparam Metric A writable metric, e.g. map_metric,
+/// @tparam WeightCmp A functor providing the means of comparing weights.
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+class dynamic_sssp {
+
+public:
+    using weight_type = typename Metric::weight_type;
+    using update_type = std::pair<edge, weight_type>;
+
+private:
+    using W = weight_type;
+    using entry = typename search_workspace<W>::entry;
+
+    const Topology& m_topology;
+    Metric& m_metric;
+    node m_src;
+    WeightCmp m_cmp;
+
+    std::vector<std::vector<node>> m_in;
+    search_workspace<W> m_ws;
+    std::vector<char> m_affected;
+
+    const W& weight(node u, node v) const
+    {
+        return static_cast<const Metric&>(m_metric)(edge(u, v));
+    }
+
+    bool has_edge(node u, node v) const
+    {
+        return std::find(begin(m_in[v]), end(m_in[v]), u) != end(m_in[v]);
+    }
+
+    bool finite(const W& x) const
+    {
+        return m_cmp(x, weight_traits<W>::inf());
+    }
+
+    bool heap_less(const entry& x, const entry& y) const
+    {
+        if (m_cmp(y.first, x.first)) return true;
+        if (m_cmp(x.first, y.first)) return false;
+        return y.second < x.second;
+    }
+
+    /// True if a Dijkstra's search settles u before v.
+    bool settled_before(node u, node v) const
+    {
+        return heap_less(entry(m_ws.dists[v], v), entry(m_ws.dists[u], u));
+    }
+
+    void relax(node u, node v)
+    {
+        auto& dists = m_ws.dists;
+        auto& preds = m_ws.preds;
+        if (!finite(dists[u])) {
+            return;
+        }
+        W new_dist = dists[u] + weight(u, v);
+        if (m_cmp(new_dist, dists[v])) {
+            dists[v] = new_dist;
+            preds[v] = u;
+            m_ws.open.emplace_back(new_dist, v);
+            std::push_heap(begin(m_ws.open), end(m_ws.open),
+                [this](const entry& x, const entry& y) { return heap_less(x, y); });
+        } else if (v != m_src && preds[v] != u && !m_cmp(dists[v], new_dist) && settled_before(u, preds[v])) {
+            // An equally short path; the distances below do not change.
+            preds[v] = u;
+        }
+    }
+
+    /// Detaches the subtree of the given root; returns the detached nodes.
+    void detach(node root, std::vector<node>& out_nodes)
+    {
+        if (root == m_src || m_affected[root] || m_ws.preds[root] == root) {
+            return;
+        }
+        const std::size_t first = out_nodes.size();
+        m_affected[root] = true;
+        out_nodes.push_back(root);
+        for (std::size_t i = first; i < out_nodes.size(); ++i) {
+            const node u = out_nodes[i];
+            std::for_each(out_begin(m_topology, u), out_end(m_topology, u), [&](node v) {
+                if (!m_affected[v] && v != u && m_ws.preds[v] == u) {
+                    m_affected[v] = true;
+                    out_nodes.push_back(v);
+                }
+            });
+        }
+    }
+
+    void propagate()
+    {
+        auto heap_cmp = [this](const entry& x, const entry& y) { return heap_less(x, y); };
+        auto& open = m_ws.open;
+        while (!open.empty()) {
+            std::pop_heap(begin(open), end(open), heap_cmp);
+            const entry top = open.back();
+            open.pop_back();
+            const node u = top.second;
+            if (m_cmp(m_ws.dists[u], top.first)) {
+                continue;
+            }
+            std::for_each(out_begin(m_topology, u), out_end(m_topology, u), [&](node v) {
+                relax(u, v);
+            });
+        }
+    }
+
+public:
+    dynamic_sssp(const Topology& t, Metric& m, node src, const WeightCmp& cmp = WeightCmp {}) :
+        m_topology { t }, m_metric { m }, m_src { src }, m_cmp { cmp }
+    {
+        const node N = max_node(t) + 1;
+        m_in.resize(N);
+        std::for_each(edge_begin(t), edge_end(t), [this](const edge& e) {
+            m_in[e.second].push_back(e.first);
+        });
+        m_affected.resize(N, false);
+        m_ws.resize(N);
+        detail::dijkstra_relax(m_topology, m_metric, m_src, m_ws, detail::never_stop {}, m_cmp);
+    }
+
+    node source() const { return m_src; }
+    const std::vector<W>& dists() const { return m_ws.dists; }
+    const std::vector<node>& preds() const { return m_ws.preds; }
+
+    tree to_tree() const { return build_tree(m_ws.preds); }
+
+    /// The path from the source to dst; empty if dst is unreachable.
+    path path_to(node dst) const
+    {
+        if (!m_ws.reached(m_src, dst)) {
+            return {};
+        }
+        return build_path(m_src, dst, m_ws.preds);
+    }
+
+    /// Applies a batch of the weight updates and repairs the tree.
+    ///
+    /// @param first, last A range of the (edge, new weight) pairs.
+    template <typename UpdateIt>
+    void update(UpdateIt first, UpdateIt last)
+    {
+        // Apply the weights and collect the changed edges in both directions,
+        // as a symmetric metric shares the weight between them.
+        std::vector<edge> changed;
+        for (; first != last; ++first) {
+            const edge& e = first->first;
+            m_metric(e) = first->second;
+            for (const edge& x : { e, reverse(e) }) {
+                if (has_edge(x.first, x.second)) {
+                    changed.push_back(x);
+                }
+            }
+        }
+
+        // Detach the subtrees hanging from the changed tree edges.
+        std::vector<node> detached;
+        for (const edge& e : changed) {
+            if (m_ws.preds[e.second] == e.first && e.second != e.first) {
+                detach(e.second, detached);
+            }
+        }
+        for (node v : detached) {
+            m_ws.dists[v] = weight_traits<W>::inf();
+            m_ws.preds[v] = v;
+        }
+
+        // Reattach the detached nodes from their unaffected in-neighbors.
+        m_ws.open.clear();
+        for (node v : detached) {
+            for (node u : m_in[v]) {
+                if (!m_affected[u]) {
+                    relax(u, v);
+                }
+            }
+        }
+        for (node v : detached) {
+            m_affected[v] = false;
+        }
+
+        // Seed the improvements through the changed edges.
+        for (const edge& e : changed) {
+            relax(e.first, e.second);
+        }
+
+        propagate();
+    }
+};
+
+#endif
@@ -0,0 +1,450 @@
+#ifndef ALGORITHMS_FAILURE_H
+#define ALGORITHMS_FAILURE_H
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <algorithm>
+
+#include "algorithms_basic.h"
+#include "topology_view.h"
+#include "parallel.h"
+
+// The failure impact analysis.
+// ============================
+
+/// A demand of a route from the first node to the second one.
+typedef std::pair<node, node> demand;
+
+/// The routes of the demands under the failures. Only the entries changed
+/// by a failure are stored, in a row per failure sorted by the demands; all
+/// the others keep the baseline route of their demand. The paths are pooled
+/// in a single array, the baseline ones first, so that the table stays
+/// compact even for millions of entries.
+///
+/// @tparam W The weight of the paths.
+template <Weight W>
+struct failure_table {
+
+    /// A changed entry of a row.
+    struct change {
+        std::uint32_t index; // the demand
+        std::uint32_t route; // the pooled path, empty if disconnected
+        W cost;              // inf if disconnected
+    };
+
+    std::vector<demand> demands;
+    std::vector<std::vector<edge>> failures;
+    std::vector<W> baseline;
+
+    std::vector<std::size_t> rows;    // the changes of the failure f are [rows[f], rows[f + 1])
+    std::vector<change> changes;
+    std::vector<std::size_t> offsets; // the pooled path r is [offsets[r], offsets[r + 1])
+    std::vector<node> hops;
+
+    std::size_t searches = 0;         // the number of the trees repaired
+
+    /// The changed entry, or nullptr if the failure keeps the baseline.
+    const change* find(std::size_t f, std::size_t d) const
+    {
+        const auto first = begin(changes) + rows[f];
+        const auto last = begin(changes) + rows[f + 1];
+        const auto it = std::lower_bound(first, last, d,
+            [](const change& c, std::size_t x) { return c.index < x; });
+        return it != last && it->index == d ? &*it : nullptr;
+    }
+
+    /// True if the failure changes the route of the demand.
+    bool affected(std::size_t f, std::size_t d) const
+    {
+        return find(f, d) != nullptr;
+    }
+
+    W cost(std::size_t f, std::size_t d) const
+    {
+        const change* c = find(f, d);
+        return c ? c->cost : baseline[d];
+    }
+
+    /// Stores the route of the demand under the failure in out_path; empty
+    /// if the failure disconnects the demand.
+    void route(std::size_t f, std::size_t d, path& out_path) const
+    {
+        const change* c = find(f, d);
+        const std::size_t r = c ? c->route : d;
+        out_path.assign(begin(hops) + offsets[r], begin(hops) + offsets[r + 1]);
+    }
+
+    path route(std::size_t f, std::size_t d) const
+    {
+        path result;
+        route(f, d, result);
+        return result;
+    }
+
+    friend memory_footprint memory_usage(const failure_table& x)
+    {
+        memory_footprint result = detail::vector_footprint(x.demands) +
+            detail::vector_footprint(x.baseline) +
+            detail::vector_footprint(x.rows) +
+            detail::vector_footprint(x.changes) +
+            detail::vector_footprint(x.offsets) +
+            detail::vector_footprint(x.hops);
+        memory_footprint groups = detail::vector_footprint(x.failures);
+        result.overhead += groups.payload + groups.overhead;
+        result.slack += groups.slack;
+        for (const auto& group : x.failures) {
+            result += detail::vector_footprint(group);
+        }
+        return result;
+    }
+};
+
+namespace detail {
+
+    /// Appends the path of the tree from src to dst to the hops, in reverse
+    /// order from the given node on; nothing if dst is not reached.
+    template <Weight W>
+    void failure_tree_path(node src, node from, const search_workspace<W>& ws, std::vector<node>& hops)
+    {
+        for (node u = from; u != src; u = ws.preds[u]) {
+            hops.push_back(u);
+        }
+        hops.push_back(src);
+    }
+
+}
+
+/// The single link failures of the topology, each of its undirected links
+/// once, in their order.
+template <class Topology>
+std::vector<std::vector<edge>> link_failures(const Topology& t)
+{
+    std::vector<edge> links;
+    std::for_each(edge_begin(t), edge_end(t), [&links](const edge& e) {
+        links.push_back(normalize(e));
+    });
+    std::sort(begin(links), end(links));
+    links.erase(std::unique(begin(links), end(links)), end(links));
+
+    std::vector<std::vector<edge>> result;
+    result.reserve(links.size());
+    for (const edge& e : links) {
+        result.push_back({ e });
+    }
+    return result;
+}
+
+/// The demands from each of the given sources to all the other nodes of the
+/// topology.
+template <class Topology, class NodeIt>
+std::vector<demand> source_demands(const Topology& t, NodeIt first, NodeIt last)
+{
+    const node N = max_node(t) + 1;
+    std::vector<demand> result;
+    for (; first != last; ++first) {
+        for (node v = 0; v < N; ++v) {
+            if (v != *first) {
+                result.emplace_back(*first, v);
+            }
+        }
+    }
+    return result;
+}
+
+/// The shortest paths of the demands under each of the failures.
+///
+/// A failure is a group of the undirected links failing together, e.g. a
+/// single link or a shared risk link group; both directions of its links
+/// are removed. The shortest path trees of the sources of the demands are
+/// computed once. A failure only changes the routes through its links,
+/// hence a tree is only repaired for the failures hitting the paths of its
+/// demands, and only in the subtrees hanging from the failed links, as in
+/// dynamic_sssp: their nodes are reattached from their unaffected
+/// in-neighbors and searched again in the view of the topology without the
+/// failed links, until the affected destinations settle. The repairs of the
+/// (failure, tree) pairs are distributed over the workers, each with
+/// a workspace of its own; the table does not depend on the number of
+/// workers.
+///
+/// @param t The topology,
+/// @param m The metric with nonnegative weights,
+/// @param demands The (source, destination) pairs tracked,
+/// @param failures The groups of the failed links,
+/// @param cmp The weight comparator functor,
+/// @param threads The number of workers, zero for the size of the current thread_pool.
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+failure_table<typename Metric::weight_type> failure_impact(
+        const Topology& t, const Metric& m,
+        std::vector<demand> demands, std::vector<std::vector<edge>> failures,
+        const WeightCmp& cmp = WeightCmp {}, unsigned threads = 0) {
+
+    using W = typename Metric::weight_type;
+    using entry = typename search_workspace<W>::entry;
+    using change = typename failure_table<W>::change;
+
+    const node N = max_node(t) + 1;
+    const unsigned workers = detail::worker_count(threads);
+    const std::size_t D = demands.size();
+
+    failure_table<W> result;
+    result.demands = std::move(demands);
+    result.failures = std::move(failures);
+    for (auto& group : result.failures) {
+        for (edge& e : group) {
+            e = normalize(e);
+        }
+    }
+
+    // The demands grouped by their sources.
+    std::vector<node> sources;
+    for (const demand& dm : result.demands) {
+        sources.push_back(dm.first);
+    }
+    std::sort(begin(sources), end(sources));
+    sources.erase(std::unique(begin(sources), end(sources)), end(sources));
+    auto source_index = [&sources](node src) -> std::size_t {
+        return std::lower_bound(begin(sources), end(sources), src) - begin(sources);
+    };
+    std::vector<std::vector<std::size_t>> by_source(sources.size());
+    for (std::size_t d = 0; d < D; ++d) {
+        by_source[source_index(result.demands[d].first)].push_back(d);
+    }
+
+    // The baseline trees.
+    std::vector<search_workspace<W>> trees(sources.size());
+    detail::parallel_for_each_index(sources.size(), workers, [&](unsigned, std::size_t s) {
+        trees[s].resize(N);
+        detail::dijkstra_relax(t, m, sources[s], trees[s], detail::never_stop {}, cmp);
+    });
+
+    result.baseline.resize(D);
+    result.offsets.push_back(0);
+    for (std::size_t d = 0; d < D; ++d) {
+        const demand& dm = result.demands[d];
+        const auto& ws = trees[source_index(dm.first)];
+        result.baseline[d] = weight_traits<W>::inf();
+        if (ws.reached(dm.first, dm.second)) {
+            result.baseline[d] = ws.dists[dm.second];
+            const std::size_t first = result.hops.size();
+            detail::failure_tree_path(dm.first, dm.second, ws, result.hops);
+            std::reverse(begin(result.hops) + first, end(result.hops));
+        }
+        result.offsets.push_back(result.hops.size());
+    }
+
+    // The links used by the baseline paths of each tree.
+    std::vector<std::pair<edge, std::size_t>> used;
+    for (std::size_t s = 0; s < sources.size(); ++s) {
+        for (std::size_t d : by_source[s]) {
+            const auto first = begin(result.hops) + result.offsets[d];
+            const auto last = begin(result.hops) + result.offsets[d + 1];
+            for (auto it = first; last - it > 1; ++it) {
+                used.emplace_back(normalize(edge(*it, *(it + 1))), s);
+            }
+        }
+    }
+    std::sort(begin(used), end(used));
+    used.erase(std::unique(begin(used), end(used)), end(used));
+
+    // The trees hit by each failure.
+    std::vector<std::pair<std::size_t, std::size_t>> tasks;
+    std::vector<std::size_t> hit;
+    for (std::size_t f = 0; f < result.failures.size(); ++f) {
+        hit.clear();
+        for (const edge& e : result.failures[f]) {
+            auto it = std::lower_bound(begin(used), end(used), std::make_pair(e, std::size_t { 0 }));
+            for (; it != end(used) && it->first == e; ++it) {
+                hit.push_back(it->second);
+            }
+        }
+        std::sort(begin(hit), end(hit));
+        hit.erase(std::unique(begin(hit), end(hit)), end(hit));
+        for (std::size_t s : hit) {
+            tasks.emplace_back(f, s);
+        }
+    }
+    result.searches = tasks.size();
+
+    std::vector<std::vector<node>> in(N);
+    std::for_each(edge_begin(t), edge_end(t), [&in](const edge& e) {
+        in[e.second].push_back(e.first);
+    });
+
+    // The repairs, each recording the new routes of its affected demands.
+    struct reroute {
+        change entry;
+        std::vector<node> hops;
+    };
+    std::vector<std::vector<reroute>> reroutes(tasks.size());
+    std::vector<search_workspace<W>> workspaces(workers);
+    std::vector<std::vector<char>> marks(workers), targets(workers);
+
+    auto heap_cmp = [&cmp](const entry& x, const entry& y) {
+        if (cmp(y.first, x.first)) return true;
+        if (cmp(x.first, y.first)) return false;
+        return y.second < x.second;
+    };
+
+    detail::parallel_for_each_index(tasks.size(), workers, [&](unsigned w, std::size_t i) {
+        const std::size_t f = tasks[i].first;
+        const node src = sources[tasks[i].second];
+        const search_workspace<W>& base = trees[tasks[i].second];
+
+        auto& ws = workspaces[w];
+        auto& detached = marks[w];
+        auto& target = targets[w];
+        if (ws.preds.empty()) {
+            ws.resize(N);
+            detached.resize(N, false);
+            target.resize(N, false);
+        }
+
+        std::vector<edge> removed_edges;
+        for (const edge& e : result.failures[f]) {
+            removed_edges.push_back(e);
+            removed_edges.push_back(reverse(e));
+        }
+        const topology_view<Topology> view { t, nullptr, removed_edges };
+
+        // Detach the subtrees hanging from the failed tree edges.
+        std::vector<node> region;
+        for (const edge& e : removed_edges) {
+            const node root = e.second;
+            if (root == src || base.preds[root] != e.first || detached[root]) {
+                continue;
+            }
+            const std::size_t first = region.size();
+            detached[root] = true;
+            region.push_back(root);
+            for (std::size_t k = first; k < region.size(); ++k) {
+                const node u = region[k];
+                std::for_each(out_begin(t, u), out_end(t, u), [&](node v) {
+                    if (!detached[v] && v != u && base.preds[v] == u) {
+                        detached[v] = true;
+                        region.push_back(v);
+                    }
+                });
+            }
+        }
+
+        std::size_t remaining = 0;
+        std::vector<std::size_t> affected;
+        for (std::size_t d : by_source[tasks[i].second]) {
+            const node dst = result.demands[d].second;
+            if (detached[dst]) {
+                affected.push_back(d);
+                remaining += !target[dst];
+                target[dst] = true;
+            }
+        }
+
+        // Reattach the detached nodes from their unaffected in-neighbors.
+        auto& open = ws.open;
+        open.clear();
+        for (node v : region) {
+            ws.dists[v] = weight_traits<W>::inf();
+            ws.preds[v] = v;
+            for (node u : in[v]) {
+                if (detached[u] || !base.reached(src, u) || view.excluded(edge(u, v))) {
+                    continue;
+                }
+                const W new_dist = base.dists[u] + m(edge(u, v));
+                if (cmp(new_dist, ws.dists[v])) {
+                    ws.dists[v] = new_dist;
+                    ws.preds[v] = u;
+                }
+            }
+            if (ws.preds[v] != v) {
+                open.emplace_back(ws.dists[v], v);
+            }
+        }
+        std::make_heap(begin(open), end(open), heap_cmp);
+
+        // The search within the detached nodes.
+        while (!open.empty() && remaining > 0) {
+            std::pop_heap(begin(open), end(open), heap_cmp);
+            const entry top = open.back();
+            open.pop_back();
+
+            const node u = top.second;
+            if (cmp(ws.dists[u], top.first)) {
+                continue;
+            }
+            if (target[u]) {
+                target[u] = false;
+                --remaining;
+            }
+
+            std::for_each(out_begin(view, u), out_end(view, u), [&](node v) {
+                if (!detached[v]) {
+                    return;
+                }
+                const W new_dist = ws.dists[u] + m(edge(u, v));
+                if (cmp(new_dist, ws.dists[v])) {
+                    ws.dists[v] = new_dist;
+                    ws.preds[v] = u;
+                    open.emplace_back(new_dist, v);
+                    std::push_heap(begin(open), end(open), heap_cmp);
+                }
+            });
+        }
+
+        // The new routes run through the detached nodes up to the first
+        // one reattached, and then along the baseline tree.
+        for (std::size_t d : affected) {
+            const node dst = result.demands[d].second;
+            target[dst] = false;
+            reroute r { { static_cast<std::uint32_t>(d), 0, weight_traits<W>::inf() }, {} };
+            if (ws.preds[dst] != dst) {
+                r.entry.cost = ws.dists[dst];
+                node u = dst;
+                for (; detached[u]; u = ws.preds[u]) {
+                    r.hops.push_back(u);
+                }
+                detail::failure_tree_path(src, u, base, r.hops);
+                std::reverse(begin(r.hops), end(r.hops));
+            }
+            reroutes[i].push_back(std::move(r));
+        }
+        for (node v : region) {
+            detached[v] = false;
+        }
+    });
+
+    std::vector<search_workspace<W>>().swap(trees);
+
+    // The rows of the changes, in the order of the demands.
+    std::vector<std::vector<std::size_t>> failure_tasks(result.failures.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        failure_tasks[tasks[i].first].push_back(i);
+    }
+    result.rows.push_back(0);
+    for (std::size_t f = 0; f < result.failures.size(); ++f) {
+        const std::size_t row = result.changes.size();
+        for (std::size_t i : failure_tasks[f]) {
+            for (reroute& r : reroutes[i]) {
+                r.entry.route = result.offsets.size() - 1;
+                result.hops.insert(end(result.hops), begin(r.hops), end(r.hops));
+                result.offsets.push_back(result.hops.size());
+                result.changes.push_back(r.entry);
+            }
+            std::vector<reroute>().swap(reroutes[i]);
+        }
+        std::sort(begin(result.changes) + row, end(result.changes),
+            [](const change& x, const change& y) { return x.index < y.index; });
+        result.rows.push_back(result.changes.size());
+    }
+
+    return result;
+}
+
+/// The shortest paths of the demands under every single link failure.
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+failure_table<typename Metric::weight_type> link_failure_impact(
+        const Topology& t, const Metric& m, std::vector<demand> demands,
+        const WeightCmp& cmp = WeightCmp {}, unsigned threads = 0) {
+    return failure_impact(t, m, std::move(demands), link_failures(t), cmp, threads);
+}
+
+#endif
@@ -4,69 +4,154 @@
 #include <type_traits>
 
 #include "algorithms_basic.h"
+#include "weight_util.h"
 
 namespace detail {
 
-    template <class Topology, class Metric, class WeightCmp>
-    bool larac_equal(const Topology& x, const Topology& y, const Metric& m, const WeightCmp& cmp) {
-        const auto wx = accumulate_weight(m, x);
-        const auto wy = accumulate_weight(m, y);
+    template <Weight W, class WeightCmp>
+    bool larac_equal(const W& wx, const W& wy, const WeightCmp& cmp) {
         return !cmp(wx, wy) && !cmp(wy, wx);
     }
 
+    /// The Lagrangian approximation loop of LARAC.
+    ///
+    /// @param pc The cheapest path, known to violate the constraint,
+    /// @param pc_weight The weight of pc,
+    /// @param pd The path of the least delay, known to fulfill the constraint,
+    /// @param pd_weight The weight of pd,
+    /// @param stats The instrumentation receiving the search events.
+    template <class Graph, class Metric, class Stats>
+    path larac_refine(
+            const Graph& g, const Metric& m, double constraint, node src, node dst,
+            search_workspace<typename Metric::weight_type>& ws,
+            path pc, typename Metric::weight_type pc_weight,
+            path pd, typename Metric::weight_type pd_weight,
+            Stats& stats)
+    {
+        using MW = typename Metric::weight_type;
+
+        path np;
+        weight_cmp_aggr<MW, weight_aggr_lincmb<MW>> lccmp {{{ 1.0, 0.0 }}}; // 1 * cost + lambda * delay
+        while (true) {
+
+            stats.iterated();
+            lccmp.m_aggr.m_factors[1] = (pc_weight[0] - pd_weight[0]) / (pd_weight[1] - pc_weight[1]);
+
+            MW np_weight = dijkstra(g, m, src, dst, ws, np, lccmp, stats);
+
+            // The search returned an end of the bracket; the rounding of the
+            // aggregated weights may otherwise hide the equality below.
+            if (np_weight == pc_weight || np_weight == pd_weight) {
+                return pd;
+            }
+
+            if (np_weight[1] > constraint) {
+                std::swap(pc, np);
+                pc_weight = np_weight;
+            } else {
+                std::swap(pd, np);
+                pd_weight = np_weight;
+            }
+
+            if (larac_equal(pc_weight, pd_weight, lccmp)) {
+                return pd;
+            }
+        }
+
+        throw std::runtime_error("Should not get here.");
+    }
+
+    /// LARAC for a source whose full cost and delay shortest path trees
+    /// have already been computed. The immediate success and failure checks
+    /// are answered from the trees, so that the searches are only run if the
+    /// approximation loop is actually needed; only then is the workspace
+    /// sized for the graph, if it is not yet.
+    template <class Graph, class Metric, class Stats>
+    path larac_with_trees(
+            const Graph& g, const Metric& m, double constraint, node src, node dst,
+            const search_workspace<typename Metric::weight_type>& cost_tree,
+            const search_workspace<typename Metric::weight_type>& delay_tree,
+            search_workspace<typename Metric::weight_type>& ws,
+            Stats& stats)
+    {
+        if (!cost_tree.reached(src, dst)) {
+            return {};
+        }
+
+        const auto& pc_weight = cost_tree.dists[dst];
+        if (pc_weight[1] <= constraint) {
+            return build_path(src, dst, cost_tree.preds);
+        }
+
+        const auto& pd_weight = delay_tree.dists[dst];
+        if (pd_weight[1] > constraint) {
+            return {};
+        }
+
+        if (ws.preds.size() < cost_tree.preds.size()) {
+            ws.resize(static_cast<node>(cost_tree.preds.size()));
+        }
+        return larac_refine(g, m, constraint, src, dst, ws,
+            build_path(src, dst, cost_tree.preds), pc_weight,
+            build_path(src, dst, delay_tree.preds), pd_weight, stats);
+    }
+
 }
 
-template <class Graph, class Metric>
-path larac(const Graph& g, const Metric& m, double constraint, node src, node dst)
+/// The LARAC algorithm finding the cheapest path between src and dst whose
+/// delay (the second weight component) does not exceed the constraint.
+/// All the searches run in the given workspace, which may be shared between
+/// subsequent calls over the same graph. The search events of all the
+/// searches are reported to the given instrumentation.
+template <class Graph, class Metric, class Stats>
+path larac(
+        const Graph& g, const Metric& m, double constraint, node src, node dst,
+        search_workspace<typename Metric::weight_type>& ws, Stats& stats)
 {
     using MW = typename Metric::weight_type;
 
     auto ccmp = weight_cmp_index<MW, 0> {};
     auto dcmp = weight_cmp_index<MW, 1> {};
 
+    path pc, pd;
+
     // Check for immediate success.
-    path pc = dijkstra(g, m, src, dst, ccmp);
-    auto pc_weight = accumulate_weight(m, pc);
-    double dpc = pc_weight[1];
-    if (dpc <= constraint) {
+    MW pc_weight = dijkstra(g, m, src, dst, ws, pc, ccmp, stats);
+    if (pc.empty()) {
+        return {};
+    }
+    if (pc_weight[1] <= constraint) {
         return pc;
     }
 
     // Check for immediate failure.
-    path pd = dijkstra(g, m, src, dst, dcmp);
-    auto pd_weight = accumulate_weight(m, pd);
-    double dpd = pd_weight[1];
-    if (dpd > constraint) {
+    MW pd_weight = dijkstra(g, m, src, dst, ws, pd, dcmp, stats);
+    if (pd_weight[1] > constraint) {
         return {};
     }
 
     // Approximation loop.
-    double cpc = pc_weight[0];
-    double cpd = pd_weight[0];
-    while (true) {
-
-        double lambda = (cpc - cpd) / (dpd - dpc);
-
-        weight_cmp_aggr<MW, weight_aggr_lincmb<MW>> lccmp {{{ 1.0, lambda }}}; // 1 * cost + lambda * delay
-        path np = dijkstra(g, m, src, dst, lccmp);
-        auto np_weight = accumulate_weight(m, np);
-
-        if (np_weight[1] > constraint) {
-            pc = np;
-            cpc = np_weight[0];
-            dpc = np_weight[1];
-        } else {
-            pd = np;
-            cpd = np_weight[0];
-            dpd = np_weight[1];
-        }
+    return detail::larac_refine(g, m, constraint, src, dst, ws,
+        std::move(pc), pc_weight, std::move(pd), pd_weight, stats);
+}
 
-        if (detail::larac_equal(pc, pd, m, lccmp)) {
-            return pd;
-        }
-    }
+template <class Graph, class Metric>
+path larac(
+        const Graph& g, const Metric& m, double constraint, node src, node dst,
+        search_workspace<typename Metric::weight_type>& ws)
+{
+    no_stats stats;
+    return larac(g, m, constraint, src, dst, ws, stats);
+}
 
-    throw std::runtime_error("Should not get here.");
+template <class Graph, class Metric>
+path larac(const Graph& g, const Metric& m, double constraint, node src, node dst)
+{
+    if (known_unreachable(g, src, dst)) {
+        return {};
+    }
+    search_workspace<typename Metric::weight_type> ws { max_node(g) + 1 };
+    return larac(g, m, constraint, src, dst, ws);
 }
 
 #endif
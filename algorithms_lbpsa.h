@@ -1,84 +1,204 @@
 #ifndef ALGORITHMS_LBPSA_H
 #define ALGORITHMS_LBPSA_H
 
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <limits>
+
+#include "algorithms_basic.h"
+#include "weight_util.h"
+#include "parallel.h"
+
+// The LBPSA multi-constrained path search.
+// ========================================
+//
+// The first weight component is the cost to be minimized, the remaining ones
+// are bounded by the constraints: cstr[i - 1] bounds the component i.
+// The search consists of a Lagrangian phase yielding the multipliers and
+// the incumbent feasible path, and a depth first branch and bound pruned with
+// the bounds derived from the multipliers and from the per-component least
+// weights towards the destination.
+
 namespace detail {
 
-    template <class Path, class Metric>
-    bool lbpsa_constraints_fulfilled(const Path &p, const Metric &m, const std::vector<double>& cstr)
-    {
-        using MW = typename Metric::weight_type;
-        using W = typename MW::weight_type;
+    /// Metric adaptor looking up the weights of the reversed edges. Together
+    /// with a reversed topology it enables the searches towards a destination.
+    template <class Metric>
+    struct reversed_metric {
+        using weight_type = typename Metric::weight_type;
+        const Metric* m;
+        weight_type operator()(const edge& e) const { return (*m)(reverse(e)); }
+    };
+
+    /// Weight compare of a single multi-weight component chosen at runtime.
+    template <MultiWeight MW>
+    struct lbpsa_index_cmp {
+        int index;
+        bool operator()(const MW& x, const MW& y) const
+        {
+            return x[index] < y[index];
+        }
+    };
 
-        std::vector<W> weight = accumulate_weight(m, p);
+    /// The bounds guiding the branch and bound phase.
+    struct lbpsa_bounds {
 
-        auto first1 = begin(weight) + 1, last1 = end(cstr);
-        auto first2 = begin(cstr), last2 = end(cstr);
-        assert(std::distance(first1, last1) == std::distance(first2, last2));
+        /// least[i][v] is the least value of the component i on any path
+        /// from v to the destination.
+        std::vector<std::vector<double>> least;
 
-        while (first1 != last1) {
-            if (*first1++ > *first2++) {
-                return false;
+        /// lagrange[v] is the least Lagrangian weight, i.e.
+        /// cost + sum(lambda_i * weight_i), on any path from v to the destination.
+        std::vector<double> lagrange;
+
+        std::vector<double> lambdas;
+
+        /// The sum of lambda_i * cstr_i.
+        double lambda_cstr = 0.0;
+
+        template <MultiWeight MW>
+        double aggregate(const MW& x) const
+        {
+            double result = x[0];
+            for (std::size_t i = 0; i < lambdas.size(); ++i) {
+                result += lambdas[i] * x[i + 1];
             }
+            return result;
         }
+    };
 
-        return true;
-    }
+    /// The best feasible path found so far, shared between the workers.
+    /// Among the paths of equal cost the lexicographically least one is kept,
+    /// so that the result does not depend on the order of the discoveries.
+    class lbpsa_incumbent {
 
-    template <class Metric>
-    int lbpsa_max_index(const Metric &m, const path &p, const std::vector<double>& cstr)
+        std::atomic<double> m_cost { std::numeric_limits<double>::infinity() };
+        std::mutex m_guard;
+        std::vector<node> m_path;
+
+    public:
+        double cost() const { return m_cost.load(std::memory_order_relaxed); }
+
+        void offer(double cost, const std::vector<node>& p)
+        {
+            if (cost > this->cost()) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock { m_guard };
+            double current = m_cost.load(std::memory_order_relaxed);
+            if (cost < current || (cost == current && (m_path.empty() || p < m_path))) {
+                m_path = p;
+                m_cost.store(cost, std::memory_order_relaxed);
+            }
+        }
+
+        path result() const { return path(begin(m_path), end(m_path)); }
+    };
+
+    template <MultiWeight MW>
+    bool lbpsa_constraints_fulfilled(const MW& w, const std::vector<double>& cstr)
     {
-        using MW = typename Metric::weight_type;
-        MW multi_weight = accumulate_weight(m, p);
-        auto max_element = std::max_element(begin(multi_weight), end(multi_weight));
-        return std::distance(begin(multi_weight), max_element);
+        for (std::size_t i = 0; i < cstr.size(); ++i) {
+            if (w[i + 1] > cstr[i]) {
+                return false;
+            }
+        }
+        return true;
     }
 
+    /// The subgradient optimization of the Lagrangian multipliers.
+    ///
+    /// @param out_lambdas The out parameter returning the multipliers of the
+    ///                    best lower bound found,
+    /// @param incumbent Collects the feasible paths found on the way.
+    /// @return The best lower bound on the cost of a feasible path or
+    ///         infinity if the destination is unreachable.
     template <class Graph, class Metric>
-    path lbpsa_feasible_find(const Graph& g, const Metric& m, const std::vector<double>& cstr, node from, node to)
+    double lbpsa_lagrange(
+            const Graph& g, const Metric& m, const std::vector<double>& cstr,
+            node src, node dst,
+            std::vector<double>& out_lambdas,
+            lbpsa_incumbent& incumbent)
     {
         using MW = typename Metric::weight_type;
-        int weight_count = MW::weight_count;
 
-        std::vector<double> lambdas { weight_count, 0.0 };
-        double UB = accumulate_cost(m, g);
+        const double inf = std::numeric_limits<double>::infinity();
+
+        // A crude upper bound used for the step size until a feasible path
+        // is known: the total cost of all the edges.
+        const double total_cost = accumulate_cost(m, g);
+
+        search_workspace<MW> ws { max_node(g) + 1 };
+        path p;
+
+        weight_cmp_aggr<MW, weight_aggr_lagrange<MW>> lcmp {{ std::vector<double>(cstr.size(), 0.0) }};
+        auto& lambdas = lcmp.m_aggr.m_factors;
+
+        double best_bound = -inf;
         double lk = 2.0;
-        double prevL = std::numeric_limits<double>::infinity;
-        int iterationsSinceLChange = 0;
+        double prev_bound = -inf;
+        int iterations_since_change = 0;
         int passes = 0;
 
+        out_lambdas = lambdas;
+
         while (true) {
 
-            weight_aggr_lagrange<MW> lc {{ lambdas }};
-            weight_cmp_aggr<MW, decltype(lc)> lccmp { lc };
+            // Find and evaluate the path.
+            // ---------------------------
+            const MW w = dijkstra(g, m, src, dst, ws, p, lcmp);
+            if (p.empty()) {
+                return inf;
+            }
+
+            double bound = w[0];
+            double slackness = 0.0;
+            double norm = 0.0;
+            for (std::size_t i = 0; i < cstr.size(); ++i) {
+                const double grad = w[i + 1] - cstr[i];
+                bound += lambdas[i] * grad;
+                slackness += lambdas[i] * grad;
+                norm += grad * grad;
+            }
+
+            if (bound > best_bound) {
+                best_bound = bound;
+                out_lambdas = lambdas;
+            }
+
+            const bool feasible = lbpsa_constraints_fulfilled(w, cstr);
+            if (feasible) {
+                incumbent.offer(w[0], std::vector<node>(begin(p), end(p)));
+                if (slackness == 0.0) {
+                    // Complementary slackness; the path is optimal.
+                    return w[0];
+                }
+            }
 
-            // Find and evaluate path.
-            // -----------------------
-            path p = dijkstra(g, m, from, to, lccmp);
-            if (!p.empty() && lbpsa_constraints_fulfilled(p, m, cstr)) {
-                UB = accumulate_cost(m, p);
-                return p;
+            if (incumbent.cost() <= best_bound || norm == 0.0) {
+                break;
             }
 
             // Iteration step.
             // ---------------
-            double L = lc(accumulate_weight(m, p));;
-            int metric = lbpsa_max_index(m, p, cstr);
-            double step = computeStep(p, m, lk, L, cstr);
-            lambdas[metric - 1] += step;
-            if (lambdas[metric - 1] < 0.0) {
-                lambdas[metric - 1] = 0.0;
-            }
-
-            // Purple magic.
-            // -------------
-            if (L == prevL) {
-                ++iterationsSinceLChange;
+            const double ub = incumbent.cost() < inf ? incumbent.cost() : total_cost;
+            const double step = lk * (ub - bound) / norm;
+            for (std::size_t i = 0; i < cstr.size(); ++i) {
+                lambdas[i] = std::max(0.0, lambdas[i] + step * (w[i + 1] - cstr[i]));
+            }
+
+            // Step size control.
+            // ------------------
+            if (bound == prev_bound) {
+                ++iterations_since_change;
             } else {
-                iterationsSinceLChange = 0;
-                prevL = L;
+                iterations_since_change = 0;
+                prev_bound = bound;
             }
-            if (iterationsSinceLChange >= 50) {
-                iterationsSinceLChange = 0;
+            if (iterations_since_change >= 5) {
+                iterations_since_change = 0;
                 lk *= 0.5;
             }
             if (++passes > 50) {
@@ -89,122 +209,262 @@ namespace detail {
                 break;
             }
         }
-        return {};
+
+        return best_bound;
     }
-/*
-    template <class Metric>
-    bool lbpsa_conditions(typename Metric::weight_type current_weight, node dst)
-    {
-        using W = typename Metric::weight_type;
-        W previous_weight = frasible_costs[dst];
 
-        // Other.
-        // ------
-        double upperBound = upper_bound;
+    /// Computes the least weights towards the destination by the searches
+    /// over the reversed graph: one per component and one for the Lagrangian
+    /// weight.
+    template <class Graph, class Metric>
+    lbpsa_bounds lbpsa_make_bounds(
+            const Graph& g, const Metric& m, const std::vector<double>& cstr,
+            node dst, const std::vector<double>& lambdas, unsigned workers)
+    {
+        using MW = typename Metric::weight_type;
 
-        double weightedConstraints = 0.0;
-        for (int m = 1; m < numMetrics; ++m) {
-            weightedConstraints += feasibleFinder.getLambdas().get(m - 1)
-                    * constraints.get(m - 1);
-        }
+        const int M = MW::weight_count;
+        const node N = max_node(g) + 1;
 
-        // Conditions.
-        // -----------
-        // Condition 1:
-        boolean cnd1 = fwdEdge.getMetrics().get(0)
-                + revEdge.getMetrics().get(0) <= upperBound;
+        adj_list rev;
+        std::for_each(edge_begin(g), edge_end(g), [&rev](const edge& e) { rev.set(reverse(e)); });
+        const reversed_metric<Metric> rm { &m };
 
-        if (!cnd1) {
-            return false;
+        lbpsa_bounds result;
+        result.lambdas = lambdas;
+        result.least.resize(M);
+        result.lagrange.resize(N);
+        for (std::size_t i = 0; i < cstr.size(); ++i) {
+            result.lambda_cstr += lambdas[i] * cstr[i];
         }
 
-        // Condition 2:
-        boolean cnd2 = true;
-        for (int i = 1; i < numMetrics; ++i) {
-
-            double value = fwdEdge.getMetrics().get(i)
-                    + revEdge.getMetrics().get(i) - constraints.get(i - 1);
-
-            if (value > 0.0) {
-                cnd2 = false;
-                break;
+        std::vector<search_workspace<MW>> workspaces(workers);
+
+        parallel_for_each_index(M + 1, workers, [&](unsigned w, std::size_t i) {
+            auto& ws = workspaces[w];
+            ws.resize(N);
+            if (static_cast<int>(i) < M) {
+                lbpsa_index_cmp<MW> cmp { static_cast<int>(i) };
+                dijkstra_relax(rev, rm, dst, ws, never_stop {}, cmp);
+                auto& least = result.least[i];
+                least.resize(N);
+                for (node v = 0; v < N; ++v) {
+                    least[v] = ws.dists[v][i];
+                }
+            } else {
+                weight_cmp_aggr<MW, weight_aggr_lagrange<MW>> cmp {{ lambdas }};
+                dijkstra_relax(rev, rm, dst, ws, never_stop {}, cmp);
+                for (node v = 0; v < N; ++v) {
+                    result.lagrange[v] = result.aggregate(ws.dists[v]);
+                }
             }
-        }
-        if (!cnd2) {
-            return false;
-        }
-
-        // Condition 3:
-        boolean cnd3 = current_weight + previous_weight <= upperBound
-                + weightedConstraints;
-
-        if (!cnd3) {
-            return false;
-        }
+        });
 
-        return true;
+        return result;
     }
 
+    /// A subtree of the branch and bound search given by its root path.
+    template <MultiWeight MW>
+    struct lbpsa_task {
+        std::vector<node> prefix;
+        MW weight;
+    };
+
+    /// The shared state of the branch and bound phase.
     template <class Graph, class Metric>
-    void lbpsa_rec(
-            const Graph& g, const Metric& m,
-            const std::vector<double>& cstr,
-            node src, node dst,
-            typename Metric::weight_type &current_weight,
-            path &current_path,
-            std::vector<path> &feasible)
-    {
-        using W = typename Metric::weight_type;
+    struct lbpsa_search {
 
-        node u = current_path.back();
+        using MW = typename Metric::weight_type;
+        using out_it = decltype(out_begin(std::declval<const Graph&>(), node {}));
+
+        const Graph& g;
+        const Metric& m;
+        const std::vector<double>& cstr;
+        node dst;
+        const lbpsa_bounds& bounds;
+        lbpsa_incumbent& incumbent;
+        std::chrono::steady_clock::time_point deadline;
+        std::atomic<bool> expired { false };
+
+        /// The pruning conditions for a path reaching v with the weight w.
+        bool admissible(const MW& w, node v) const
+        {
+            // Condition 1: the destination must be reachable and the least
+            // possible cost must not exceed the incumbent.
+            const double least_cost = w[0] + bounds.least[0][v];
+            if (least_cost == std::numeric_limits<double>::infinity()) {
+                return false;
+            }
+            const double ub = incumbent.cost();
+            const double tolerance = 1e-9 * std::abs(ub);
+            if (least_cost > ub + tolerance) {
+                return false;
+            }
 
-        if (u == src) {
-            feasible.push_back(current_path);
-            return;
-        }
+            // Condition 2: each constraint must be satisfiable.
+            for (std::size_t i = 0; i < cstr.size(); ++i) {
+                if (w[i + 1] + bounds.least[i + 1][v] > cstr[i]) {
+                    return false;
+                }
+            }
 
-        auto first = out_begin(g, u);
-        const auto last = out_end(g, u);
-        while (first != last) {
+            // Condition 3: the Lagrangian lower bound must not exceed
+            // the incumbent.
+            const double lagrange_bound = bounds.aggregate(w) + bounds.lagrange[v] - bounds.lambda_cstr;
+            return lagrange_bound <= ub + tolerance;
+        }
 
-            node v = *first++;
+        /// Depth first search of the subtree with an explicit stack.
+        void run(const lbpsa_task<MW>& task, std::vector<char>& on_path)
+        {
+            struct frame {
+                out_it first, last;
+                MW weight;
+            };
+
+            std::vector<node> current = task.prefix;
+            for (node n : current) {
+                on_path[n] = true;
+            }
 
-            if (std::find(begin(current_path), end(current_path), v) != end(path)) {
-                continue;
+            std::vector<frame> stack;
+            node u = current.back();
+            stack.push_back({ out_begin(g, u), out_end(g, u), task.weight });
+
+            unsigned expansions = 0;
+            while (!stack.empty()) {
+
+                if ((++expansions & 1023) == 0 && std::chrono::steady_clock::now() > deadline) {
+                    expired.store(true, std::memory_order_relaxed);
+                }
+                if (expired.load(std::memory_order_relaxed)) {
+                    break;
+                }
+
+                frame& f = stack.back();
+                if (f.first == f.last) {
+                    on_path[current.back()] = false;
+                    current.pop_back();
+                    stack.pop_back();
+                    continue;
+                }
+
+                u = current.back();
+                const node v = *f.first;
+                ++f.first;
+
+                if (on_path[v]) {
+                    continue;
+                }
+
+                const MW w = f.weight + m(edge(u, v));
+                if (!admissible(w, v)) {
+                    continue;
+                }
+
+                current.push_back(v);
+                if (v == dst) {
+                    incumbent.offer(w[0], current);
+                    current.pop_back();
+                    continue;
+                }
+
+                on_path[v] = true;
+                stack.push_back({ out_begin(g, v), out_end(g, v), w });
             }
 
-            edge e { u, v };
+            for (node n : current) {
+                on_path[n] = false;
+            }
+        }
 
-            W old_weight = current_weight;
-            current_weight = old_weight + m(e);
-            if (detail::lbpsa_conditions(e)) {
-                currentPath.push_back(v);
-                lbpsa_rec(g, m, cstr, src, dst, current_weight, current_path, feasible);
-                currentPath.pop_back();
+        /// Splits the search tree into at least min_tasks subtrees by
+        /// expanding the shallow levels breadth first.
+        std::vector<lbpsa_task<MW>> split(lbpsa_task<MW> root, std::size_t min_tasks, int max_depth)
+        {
+            std::vector<lbpsa_task<MW>> tasks { std::move(root) };
+            for (int depth = 0; depth < max_depth && tasks.size() < min_tasks; ++depth) {
+                std::vector<lbpsa_task<MW>> next;
+                for (const auto& task : tasks) {
+                    const node u = task.prefix.back();
+                    std::for_each(out_begin(g, u), out_end(g, u), [&](node v) {
+                        if (std::find(begin(task.prefix), end(task.prefix), v) != end(task.prefix)) {
+                            return;
+                        }
+                        const MW w = task.weight + m(edge(u, v));
+                        if (!admissible(w, v)) {
+                            return;
+                        }
+                        std::vector<node> prefix = task.prefix;
+                        prefix.push_back(v);
+                        if (v == dst) {
+                            incumbent.offer(w[0], prefix);
+                        } else {
+                            next.push_back({ std::move(prefix), w });
+                        }
+                    });
+                }
+                tasks = std::move(next);
             }
-            current_weight = old_weight;
+            return tasks;
         }
-    }
-*/
+    };
+
 }
 
+/// Finds the cheapest path between src and dst fulfilling all the
+/// constraints, or an empty path if there is none.
+///
+/// @param g The graph,
+/// @param m The multi-weight metric; the first component is the cost,
+/// @param cstr The upper bounds of the remaining components,
+/// @param src The source node,
+/// @param dst The destination node,
+/// @param threads The number of workers, zero for the size of the current thread_pool,
+/// @param deadline The time after which the best path found so far is
+///                 returned even if its optimality has not been proven.
 template <class Graph, class Metric>
-path lbpsa(const Graph& g, const Metric& m, const std::vector<double>& cstr, node src, node dst)
+path lbpsa(
+        const Graph& g, const Metric& m, const std::vector<double>& cstr, node src, node dst,
+        unsigned threads = 0,
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max())
 {
-    std::vector<path> fsbl = lbpsa_feasible_find(g, m, cstr, src, dst);
-/*
-    detail::lbpsa_rec(g, m, cstr, src, dst, wth, res, fsbl);
+    using MW = typename Metric::weight_type;
 
-    if (fsbl.empty()) {
-        return {};
+    assert(static_cast<int>(cstr.size()) == MW::weight_count - 1);
 
-    } else {
-        return *std::min_element(begin(fsbl), end(fsbl), [&m](const path& x, const path& y) {
-            return accumulate_weight(m, x) < accumulate_weight(m, y);
-        });
+    detail::lbpsa_incumbent incumbent;
+    std::vector<double> lambdas;
+
+    const double lower_bound = detail::lbpsa_lagrange(g, m, cstr, src, dst, lambdas, incumbent);
+    if (lower_bound == std::numeric_limits<double>::infinity()) {
+        return {};
+    }
+    if (incumbent.cost() <= lower_bound) {
+        return incumbent.result();
     }
-*/
-    return {};
+
+    const unsigned workers = detail::worker_count(threads);
+    const detail::lbpsa_bounds bounds = detail::lbpsa_make_bounds(g, m, cstr, dst, lambdas, workers);
+
+    detail::lbpsa_search<Graph, Metric> search { g, m, cstr, dst, bounds, incumbent, deadline };
+
+    detail::lbpsa_task<MW> root { { src }, weight_traits<MW>::zero() };
+    const auto tasks = workers > 1
+        ? search.split(std::move(root), 4 * workers, 4)
+        : std::vector<detail::lbpsa_task<MW>> { std::move(root) };
+
+    const node N = max_node(g) + 1;
+    std::vector<std::vector<char>> on_path(workers);
+
+    detail::parallel_for_each_index(tasks.size(), workers, [&](unsigned w, std::size_t i) {
+        if (on_path[w].empty()) {
+            on_path[w].resize(N, false);
+        }
+        search.run(tasks[i], on_path[w]);
+    });
+
+    return incumbent.result();
 }
 
 #endif
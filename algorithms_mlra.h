@@ -2,37 +2,267 @@
 #define ALGORITHMS_MLRA_H
 
 #include "algorithms_larac.h"
+#include "parallel.h"
 
 namespace detail {
 
     // void mlra_delete_leaves(...) { This is probably very rarely needed; if ever... }
 
+    /// The union of the paths reduced to the shortest path tree of the source.
+    template <class Metric>
+    tree mlra_merge(const std::vector<path>& paths, const Metric& m, node src)
+    {
+        using W = typename Metric::weight_type;
+
+        tree result;
+
+        for (const path& p : paths) {
+            std::for_each(edge_begin(p), edge_end(p), [&result](const edge& e) {
+                result.set(e);
+                result.set(reverse(e));
+            });
+        }
+
+        return shortest_path_tree(result, m, src, weight_cmp_cost<W> {});
+    }
+
 }
 
-template <class Graph, class Metric, class NodeIt>
-tree mlra(const Graph& g, const Metric& m, double constraint, node src, NodeIt dst_begin, NodeIt dst_end)
+/// The MLRA multicast tree: the union of the LARAC paths to all the
+/// destinations reduced to the shortest path tree of the source.
+///
+/// The cost and delay shortest path trees of the source are computed once
+/// and shared by all the destinations; most of them are resolved by these
+/// trees alone. The remaining per-destination LARAC runs are independent of
+/// each other and are distributed over the workers, each with a workspace of
+/// its own. The paths are merged in the order of the destinations afterwards,
+/// so the result does not depend on the number of workers.
+///
+/// The search events are counted by every worker in an instrumentation
+/// object of its own; these are merged into stats at the end.
+template <class Graph, class Metric, class NodeIt, class Stats>
+tree mlra(
+        const Graph& g, const Metric& m, double constraint, node src,
+        NodeIt dst_begin, NodeIt dst_end, unsigned threads, Stats& stats)
 {
     using W = typename Metric::weight_type;
 
-    tree result;
+    const std::vector<node> dsts(dst_begin, dst_end);
+    if (std::any_of(begin(dsts), end(dsts), [&g, src](node dst) { return known_unreachable(g, src, dst); })) {
+        return {};
+    }
+    const unsigned workers = detail::worker_count(threads);
+    const node N = max_node(g) + 1;
+
+    std::vector<Stats> worker_stats(workers);
 
-    while (dst_begin != dst_end) {
-        const auto& dst = *dst_begin++;
-        path p = larac(g, m, constraint, src, dst);
-        if (p.empty()) {
-            return {};
+    // The single criterion trees shared by all the destinations.
+    search_workspace<W> cost_tree { N }, delay_tree { N };
+    detail::parallel_for_each_index(2, workers, [&](unsigned w, std::size_t i) {
+        if (i == 0) {
+            detail::dijkstra_relax(g, m, src, cost_tree, detail::never_stop {}, weight_cmp_index<W, 0> {}, worker_stats[w]);
         } else {
-            std::for_each(edge_begin(p), edge_end(p), [&result](const edge& e) {
-                result.set(e);
-                result.set(reverse(e));
-            });
+            detail::dijkstra_relax(g, m, src, delay_tree, detail::never_stop {}, weight_cmp_index<W, 1> {}, worker_stats[w]);
+        }
+    });
+
+    std::vector<search_workspace<W>> workspaces(workers);
+    std::vector<path> paths(dsts.size());
+    std::atomic<bool> failed { false };
+
+    detail::parallel_for_each_index(dsts.size(), workers, [&](unsigned w, std::size_t i) {
+        if (failed.load(std::memory_order_relaxed)) {
+            return;
         }
+        // The workspaces are sized by the refinement only, as most of the
+        // destinations never need one.
+        paths[i] = detail::larac_with_trees(g, m, constraint, src, dsts[i], cost_tree, delay_tree, workspaces[w], worker_stats[w]);
+        if (paths[i].empty()) {
+            failed.store(true, std::memory_order_relaxed);
+        }
+    });
+
+    for (const Stats& s : worker_stats) {
+        stats.merge(s);
+    }
+
+    if (failed.load()) {
+        return {};
     }
 
-    result = prim(result, m, src, weight_cmp_cost<W> {});
     // result = detail::mlra_delete_leaves(result, dst_begin, dst_end);
+    return detail::mlra_merge(paths, m, src);
+}
+
+template <class Graph, class Metric, class NodeIt>
+tree mlra(
+        const Graph& g, const Metric& m, double constraint, node src,
+        NodeIt dst_begin, NodeIt dst_end, unsigned threads = 0)
+{
+    no_stats stats;
+    return mlra(g, m, constraint, src, dst_begin, dst_end, threads, stats);
+}
+
+/// The delay constrained paths from the source to all the destinations by
+/// the Lagrangian relaxation of LARAC run over the full shortest path trees.
+///
+/// The cost and delay trees bracket every destination as in LARAC. Then each
+/// pass picks a single lambda, the most common one of the pending brackets
+/// (or their median if they all differ), and runs a single search of the
+/// whole tree for it, which serves all the destinations at once: every path
+/// of the tree is optimal for lambda, i.e. a vertex of the lower hull of the
+/// destination's paths, so it narrows the destination's bracket whenever it
+/// lies inside it. A destination whose bracket the tree does not improve upon
+/// at the bracket's own lambda has converged. The passes repeat while they
+/// narrow or resolve any bracket; only the remaining destinations are
+/// refined one by one, over the workers, from their narrowed brackets.
+///
+/// The trees are not searched at all if every destination is known to be
+/// unreachable.
+///
+/// @return The paths in the order of the destinations; empty for the
+///         destinations without a feasible path.
+template <class Graph, class Metric, class NodeIt, class Stats>
+std::vector<path> larac_paths(
+        const Graph& g, const Metric& m, double constraint, node src,
+        NodeIt dst_begin, NodeIt dst_end, unsigned threads, Stats& stats)
+{
+    using W = typename Metric::weight_type;
+    using lincmb_cmp = weight_cmp_aggr<W, weight_aggr_lincmb<W>>;
 
-    return result;
+    const std::vector<node> dsts(dst_begin, dst_end);
+    if (std::all_of(begin(dsts), end(dsts), [&g, src](node dst) { return known_unreachable(g, src, dst); })) {
+        return std::vector<path>(dsts.size());
+    }
+    const unsigned workers = detail::worker_count(threads);
+    const node N = max_node(g) + 1;
+    const int max_passes = 64;
+
+    std::vector<Stats> worker_stats(workers);
+
+    search_workspace<W> cost_tree { N }, delay_tree { N };
+    detail::parallel_for_each_index(2, workers, [&](unsigned w, std::size_t i) {
+        if (i == 0) {
+            detail::dijkstra_relax(g, m, src, cost_tree, detail::never_stop {}, weight_cmp_index<W, 0> {}, worker_stats[w]);
+        } else {
+            detail::dijkstra_relax(g, m, src, delay_tree, detail::never_stop {}, weight_cmp_index<W, 1> {}, worker_stats[w]);
+        }
+    });
+
+    // The brackets of the destinations not resolved by the trees alone.
+    struct bracket {
+        std::size_t index;
+        path pc, pd;
+        W pc_weight, pd_weight;
+
+        double lambda() const { return (pc_weight[0] - pd_weight[0]) / (pd_weight[1] - pc_weight[1]); }
+    };
+
+    std::vector<path> paths(dsts.size());
+    std::vector<bracket> pending;
+    for (std::size_t i = 0; i < dsts.size(); ++i) {
+        const node dst = dsts[i];
+        if (!cost_tree.reached(src, dst)) {
+            continue;
+        }
+        if (cost_tree.dists[dst][1] <= constraint) {
+            paths[i] = build_path(src, dst, cost_tree.preds);
+        } else if (delay_tree.dists[dst][1] <= constraint) {
+            pending.push_back({ i,
+                build_path(src, dst, cost_tree.preds), build_path(src, dst, delay_tree.preds),
+                cost_tree.dists[dst], delay_tree.dists[dst] });
+        }
+    }
+
+    // The shared passes.
+    search_workspace<W> ws { N };
+    std::vector<double> lambdas;
+    for (int pass = 0; pass < max_passes && !pending.empty(); ++pass) {
+
+        lambdas.clear();
+        for (const bracket& b : pending) {
+            lambdas.push_back(b.lambda());
+        }
+        std::sort(begin(lambdas), end(lambdas));
+        double lambda = lambdas[lambdas.size() / 2];
+        std::size_t most = 1;
+        for (std::size_t i = 0, j = 0; i < lambdas.size(); i = j) {
+            while (j < lambdas.size() && lambdas[j] == lambdas[i]) {
+                ++j;
+            }
+            if (j - i > most) {
+                most = j - i;
+                lambda = lambdas[i];
+            }
+        }
+
+        detail::dijkstra_relax(g, m, src, ws, detail::never_stop {}, lincmb_cmp {{{ 1.0, lambda }}}, stats);
+        stats.iterated();
+
+        bool progress = false;
+        std::vector<bracket> unresolved;
+        for (bracket& b : pending) {
+            const node dst = dsts[b.index];
+            const W& np_weight = ws.dists[dst];
+            if (np_weight[1] > constraint && np_weight[1] < b.pc_weight[1]) {
+                build_path(src, dst, ws.preds, b.pc);
+                b.pc_weight = np_weight;
+                progress = true;
+            } else if (np_weight[1] <= constraint && np_weight[0] < b.pd_weight[0]) {
+                build_path(src, dst, ws.preds, b.pd);
+                b.pd_weight = np_weight;
+                progress = true;
+            } else if (b.lambda() == lambda) {
+                // The tree holds no path below the bracket's hull edge.
+                paths[b.index] = std::move(b.pd);
+                progress = true;
+                continue;
+            }
+            unresolved.push_back(std::move(b));
+        }
+        pending = std::move(unresolved);
+
+        if (!progress) {
+            break;
+        }
+    }
+
+    // The refinement of the remaining destinations.
+    std::vector<search_workspace<W>> workspaces(workers);
+    detail::parallel_for_each_index(pending.size(), workers, [&](unsigned w, std::size_t i) {
+        auto& ws = workspaces[w];
+        if (ws.preds.empty()) {
+            ws.resize(N);
+        }
+        bracket& b = pending[i];
+        paths[b.index] = detail::larac_refine(g, m, constraint, src, dsts[b.index], ws,
+            std::move(b.pc), b.pc_weight, std::move(b.pd), b.pd_weight, worker_stats[w]);
+    });
+
+    for (const Stats& s : worker_stats) {
+        stats.merge(s);
+    }
+
+    return paths;
+}
+
+/// The multicast tree of the delay constrained paths found by larac_paths
+/// reduced to the shortest path tree of the source, as by mlra; it is
+/// empty if any destination has no feasible path.
+template <class Graph, class Metric, class NodeIt>
+tree larac_tree(
+        const Graph& g, const Metric& m, double constraint, node src,
+        NodeIt dst_begin, NodeIt dst_end, unsigned threads = 0)
+{
+    if (std::any_of(dst_begin, dst_end, [&g, src](node dst) { return known_unreachable(g, src, dst); })) {
+        return {};
+    }
+    no_stats stats;
+    const std::vector<path> paths = larac_paths(g, m, constraint, src, dst_begin, dst_end, threads, stats);
+    if (std::any_of(begin(paths), end(paths), [](const path& p) { return p.empty(); })) {
+        return {};
+    }
+    return detail::mlra_merge(paths, m, src);
 }
 
 #endif
@@ -0,0 +1,368 @@
+#ifndef ALGORITHMS_PARALLEL_H
+#define ALGORITHMS_PARALLEL_H
+
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+
+#include "algorithms_basic.h"
+#include "parallel.h"
+
+// Multi-threaded variants of the topological optimization algorithms.
+// ====================================================================
+
+namespace detail {
+
+    /// A weight cell supporting the concurrent "store if less" operation.
+    /// Arithmetic weights are kept in a std::atomic and updated with
+    /// a compare-and-swap loop; any other weight (e.g. array_weight) is
+    /// guarded by a tiny per-cell spin lock.
+    template <Weight W, bool = std::is_arithmetic<W>::value>
+    class atomic_weight {
+
+        std::atomic<W> m_value { weight_traits<W>::inf() };
+
+    public:
+        W load() const
+        {
+            return m_value.load(std::memory_order_relaxed);
+        }
+
+        void store(const W& x)
+        {
+            m_value.store(x, std::memory_order_relaxed);
+        }
+
+        template <typename WeightCmp>
+        bool fetch_min(const W& x, const WeightCmp& cmp)
+        {
+            W current = m_value.load(std::memory_order_relaxed);
+            while (cmp(x, current)) {
+                if (m_value.compare_exchange_weak(current, x, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    template <Weight W>
+    class atomic_weight<W, false> {
+
+        mutable std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+        W m_value = weight_traits<W>::inf();
+
+        void lock() const { while (m_lock.test_and_set(std::memory_order_acquire)); }
+        void unlock() const { m_lock.clear(std::memory_order_release); }
+
+    public:
+        W load() const
+        {
+            lock();
+            W result = m_value;
+            unlock();
+            return result;
+        }
+
+        void store(const W& x)
+        {
+            lock();
+            m_value = x;
+            unlock();
+        }
+
+        template <typename WeightCmp>
+        bool fetch_min(const W& x, const WeightCmp& cmp)
+        {
+            lock();
+            bool result = cmp(x, m_value);
+            if (result) {
+                m_value = x;
+            }
+            unlock();
+            return result;
+        }
+    };
+
+    /// Calls f(first, last) with a random access range of all the edges of
+    /// the topology. Topologies that only provide forward edge iterators get
+    /// their edges copied into a temporary buffer first.
+    template <class Topology, typename F>
+    void with_edge_range(const Topology& t, F f, std::random_access_iterator_tag)
+    {
+        f(edge_begin(t), edge_end(t));
+    }
+
+    template <class Topology, typename F>
+    void with_edge_range(const Topology& t, F f, std::forward_iterator_tag)
+    {
+        const std::vector<edge> edges(edge_begin(t), edge_end(t));
+        f(edges.cbegin(), edges.cend());
+    }
+
+    template <class Topology, typename F>
+    void with_edge_range(const Topology& t, F f)
+    {
+        using It = decltype(edge_begin(t));
+        with_edge_range(t, f, typename std::iterator_traits<It>::iterator_category {});
+    }
+
+    /// Rebuilds the predecessors' map from the final distances by a breadth
+    /// first traversal over the "tight" edges, i.e. the edges (u, v) for which
+    /// dist(u) + m(u, v) is equivalent to dist(v). Unlike recording the
+    /// predecessor along with each concurrent update this always yields
+    /// a tree consistent with the distances.
+    template <class Topology, class Metric, typename WeightCmp>
+    void tight_edge_preds(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            const std::vector<typename Metric::weight_type>& dists,
+            std::vector<node>& out_preds,
+            const WeightCmp& cmp) {
+
+        const node N = dists.size();
+
+        out_preds.clear();
+        for (node n = 0; n < N; ++n) {
+            out_preds.push_back(n);
+        }
+
+        std::vector<bool> visited(N, false);
+        std::deque<node> queue { src };
+        visited[src] = true;
+
+        while (!queue.empty()) {
+            node u = queue.front();
+            queue.pop_front();
+            std::for_each(out_begin(t, u), out_end(t, u), [&](node v) {
+                if (visited[v]) {
+                    return;
+                }
+                const auto new_dist = dists[u] + m(edge(u, v));
+                if (!cmp(new_dist, dists[v]) && !cmp(dists[v], new_dist)) {
+                    visited[v] = true;
+                    out_preds[v] = u;
+                    queue.push_back(v);
+                }
+            });
+        }
+    }
+
+    /// The edge-parallel Bellman-Ford relaxation.
+    ///
+    /// The edge set is partitioned into contiguous ranges, one per worker.
+    /// In each round the ranges are relaxed concurrently with the atomic
+    /// min-updates of the distances; the relaxation stops after the first
+    /// round in which no distance has changed.
+    ///
+    /// @tparam Topology A topology,
+    /// @tparam Metric A metric,
+    /// @tparam WeightCmp A strict weak order on the metric's weights.
+    ///
+    /// @param t The topology,
+    /// @param m The metric,
+    /// @param src The source of the relaxation,
+    /// @param out_preds The out parameter returning the predecessors' map,
+    /// @param out_dists The out parameter returning the distances' map.
+    /// @param cmp The weight comparator functor,
+    /// @param threads The number of workers, zero for the size of the current thread_pool.
+    template <class Topology, class Metric, typename WeightCmp>
+    void parallel_bellman_ford_relax(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            std::vector<node>& out_preds,
+            std::vector<typename Metric::weight_type>& out_dists,
+            const WeightCmp& cmp,
+            unsigned threads = 0) {
+
+        using W = typename Metric::weight_type;
+
+        const node N = max_node(t) + 1;
+        const W inf = weight_traits<W>::inf();
+        const unsigned workers = worker_count(threads);
+
+        std::vector<atomic_weight<W>> dists(N);
+        dists[src].store(weight_traits<W>::zero());
+
+        with_edge_range(t, [&](auto first, auto last) {
+            const std::size_t count = std::distance(first, last);
+            for (node i = 0; i < (N - 1); ++i) {
+                std::atomic<bool> changed { false };
+                parallel_blocks(count, workers, [&](unsigned, std::size_t b, std::size_t e) {
+                    bool local_changed = false;
+                    for (auto it = first + b; it != first + e; ++it) {
+                        const edge uv = *it;
+                        const W du = dists[uv.first].load();
+                        if (!cmp(du, inf)) {
+                            continue;
+                        }
+                        if (dists[uv.second].fetch_min(du + m(uv), cmp)) {
+                            local_changed = true;
+                        }
+                    }
+                    if (local_changed) {
+                        changed.store(true, std::memory_order_relaxed);
+                    }
+                });
+                if (!changed.load()) {
+                    break;
+                }
+            }
+        });
+
+        out_dists.clear();
+        for (const auto& d : dists) {
+            out_dists.push_back(d.load());
+        }
+
+        tight_edge_preds(t, m, src, out_dists, out_preds, cmp);
+    }
+
+
+    /// Borůvka's minimum spanning forest algorithm.
+    ///
+    /// In each round every worker scans its block of edges and offers each
+    /// edge crossing two components as the candidate cheapest edge of both
+    /// components; the candidates are kept as atomic edge indices. The
+    /// candidates are then merged with the disjoint sets forest. Ties are
+    /// broken by the normalized edge, so the order is total and no cycles
+    /// arise. The edges are treated as undirected.
+    ///
+    /// @param t The topology,
+    /// @param m The metric,
+    /// @param out_edges The out parameter returning the edges of the forest,
+    /// @param cmp The weight comparator functor,
+    /// @param threads The number of workers, zero for the size of the current thread_pool.
+    template <class Topology, class Metric, typename WeightCmp>
+    void boruvka_select(
+            const Topology& t,
+            const Metric& m,
+            std::vector<edge>& out_edges,
+            const WeightCmp& cmp,
+            unsigned threads = 0) {
+
+        using W = typename Metric::weight_type;
+
+        const node N = max_node(t) + 1;
+        const unsigned workers = worker_count(threads);
+        const std::size_t none = std::numeric_limits<std::size_t>::max();
+
+        out_edges.clear();
+
+        with_edge_range(t, [&](auto first, auto last) {
+            const std::size_t count = std::distance(first, last);
+
+            std::vector<W> weights(count);
+            parallel_blocks(count, workers, [&](unsigned, std::size_t b, std::size_t e) {
+                for (std::size_t i = b; i != e; ++i) {
+                    weights[i] = m(first[i]);
+                }
+            });
+
+            auto lighter = [&](std::size_t x, std::size_t y) {
+                if (y == none) return true;
+                if (cmp(weights[x], weights[y])) return true;
+                if (cmp(weights[y], weights[x])) return false;
+                return normalize(first[x]) < normalize(first[y]);
+            };
+
+            auto offer = [&lighter](std::atomic<std::size_t>& cell, std::size_t i) {
+                std::size_t current = cell.load(std::memory_order_relaxed);
+                while (current != i && lighter(i, current)) {
+                    if (cell.compare_exchange_weak(current, i, std::memory_order_relaxed)) {
+                        return;
+                    }
+                }
+            };
+
+            disjoint_sets sets { N };
+            std::vector<node> comp(N);
+            std::vector<std::atomic<std::size_t>> cheapest(N);
+
+            bool merged = true;
+            while (merged) {
+                merged = false;
+
+                for (node n = 0; n < N; ++n) {
+                    comp[n] = sets.find(n);
+                    cheapest[n].store(none, std::memory_order_relaxed);
+                }
+
+                parallel_blocks(count, workers, [&](unsigned, std::size_t b, std::size_t e) {
+                    for (std::size_t i = b; i != e; ++i) {
+                        const node cu = comp[first[i].first];
+                        const node cv = comp[first[i].second];
+                        if (cu != cv) {
+                            offer(cheapest[cu], i);
+                            offer(cheapest[cv], i);
+                        }
+                    }
+                });
+
+                for (node n = 0; n < N; ++n) {
+                    const std::size_t i = cheapest[n].load(std::memory_order_relaxed);
+                    if (i != none && sets.unite(first[i].first, first[i].second)) {
+                        out_edges.push_back(first[i]);
+                        merged = true;
+                    }
+                }
+            }
+        });
+    }
+
+}
+
+// The convenient API for the parallel algorithms.
+// ===============================================
+
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+path parallel_bellman_ford(
+        const Topology& t, const Metric& m, node src, node dst,
+        const WeightCmp& cmp = WeightCmp {}, unsigned threads = 0) {
+    std::vector<node> preds;
+    std::vector<typename Metric::weight_type> dists;
+    detail::parallel_bellman_ford_relax(t, m, src, preds, dists, cmp, threads);
+    return build_path(src, dst, preds);
+}
+
+/// The sum of the weights of all the edges of the topology. The partial
+/// sums of the blocks of edges are combined in the order of the blocks, so
+/// the result only depends on the number of workers.
+template <class Metric, class Topology>
+typename Metric::weight_type parallel_accumulate_weight(const Metric& m, const Topology& t, unsigned threads = 0)
+{
+    using W = typename Metric::weight_type;
+
+    const unsigned workers = detail::worker_count(threads);
+    std::vector<W> partial(workers, weight_traits<W>::zero());
+
+    detail::with_edge_range(t, [&](auto first, auto last) {
+        const std::size_t count = std::distance(first, last);
+        detail::parallel_blocks(count, workers, [&](unsigned w, std::size_t b, std::size_t e) {
+            W sum = weight_traits<W>::zero();
+            for (auto it = first + b; it != first + e; ++it) {
+                sum = sum + m(*it);
+            }
+            partial[w] = sum;
+        });
+    });
+
+    return std::accumulate(begin(partial), end(partial), weight_traits<W>::zero(),
+        [](const W& x, const W& y) { return x + y; });
+}
+
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+tree boruvka(const Topology& t, const Metric& m, const WeightCmp& cmp = WeightCmp {}, unsigned threads = 0) {
+    std::vector<edge> edges;
+    detail::boruvka_select(t, m, edges, cmp, threads);
+    std::vector<node> preds;
+    detail::orient_forest(max_node(t) + 1, edges, preds);
+    return build_tree(preds);
+}
+
+#endif
@@ -0,0 +1,240 @@
+#ifndef ALGORITHMS_PARETO_H
+#define ALGORITHMS_PARETO_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "algorithms_basic.h"
+
+// The exact multi-criteria shortest paths.
+// ========================================
+
+namespace detail {
+
+    /// The label of a multi-criteria search, i.e. a non-dominated weight of
+    /// a partial path ending in a given node.
+    template <MultiWeight MW>
+    struct pareto_label {
+        MW weight;
+        node at;
+        std::uint32_t pred;
+        bool dead;
+    };
+
+    /// The arena of the labels. The labels are allocated in fixed size
+    /// blocks, never move and are referred to by their indices; all of them
+    /// are released together with the arena.
+    template <MultiWeight MW>
+    class label_arena {
+
+        static const std::uint32_t block_bits = 12;
+        static const std::uint32_t block_size = 1u << block_bits;
+
+        std::vector<std::unique_ptr<pareto_label<MW>[]>> m_blocks;
+        std::uint32_t m_size = 0;
+
+    public:
+        static const std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t allocate(const MW& weight, node at, std::uint32_t pred)
+        {
+            if ((m_size >> block_bits) == m_blocks.size()) {
+                m_blocks.emplace_back(new pareto_label<MW>[block_size]);
+            }
+            const std::uint32_t index = m_size++;
+            (*this)[index] = { weight, at, pred, false };
+            return index;
+        }
+
+        pareto_label<MW>& operator[](std::uint32_t index)
+        {
+            return m_blocks[index >> block_bits][index & (block_size - 1)];
+        }
+
+        const pareto_label<MW>& operator[](std::uint32_t index) const
+        {
+            return m_blocks[index >> block_bits][index & (block_size - 1)];
+        }
+
+        std::uint32_t size() const { return m_size; }
+
+        void clear() { m_size = 0; }
+    };
+
+    template <MultiWeight MW>
+    const std::uint32_t label_arena<MW>::none;
+
+    /// True if x is not worse than y in any of the components.
+    template <MultiWeight MW>
+    bool weakly_dominates(const MW& x, const MW& y)
+    {
+        for (int i = 0; i < MW::weight_count; ++i) {
+            if (y[i] < x[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// True if x does not violate any of the constraints; cstr[i - 1] bounds
+    /// the component i. An empty constraints' vector imposes no bounds.
+    template <MultiWeight MW>
+    bool pareto_within(const MW& x, const std::vector<double>& cstr)
+    {
+        for (std::size_t i = 0; i < cstr.size(); ++i) {
+            if (x[i + 1] > cstr[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// The multi-criteria label setting search.
+    ///
+    /// The labels are settled in the lexicographic order of their weights,
+    /// hence a settled label can never be dominated later. Each node keeps
+    /// a flat bucket of its live labels; a new label is discarded if it is
+    /// weakly dominated by a label in its bucket or in the bucket of the
+    /// destination, otherwise it kills the labels it dominates.
+    ///
+    /// @param t The topology,
+    /// @param m The multi-weight metric,
+    /// @param src The source node,
+    /// @param dst The destination node,
+    /// @param cstr The optional constraints pruning the labels,
+    /// @param arena The arena of the labels,
+    /// @param buckets The out parameter returning the live labels per node.
+    template <class Topology, class Metric>
+    void pareto_relax(
+            const Topology& t,
+            const Metric& m,
+            node src,
+            node dst,
+            const std::vector<double>& cstr,
+            label_arena<typename Metric::weight_type>& arena,
+            std::vector<std::vector<std::uint32_t>>& buckets) {
+
+        using MW = typename Metric::weight_type;
+
+        const node N = max_node(t) + 1;
+
+        arena.clear();
+        buckets.resize(N);
+        for (auto& bucket : buckets) {
+            bucket.clear();
+        }
+
+        auto lex_greater = [&arena](std::uint32_t x, std::uint32_t y) {
+            const MW& wx = arena[x].weight;
+            const MW& wy = arena[y].weight;
+            if (std::lexicographical_compare(wy.begin(), wy.end(), wx.begin(), wx.end())) return true;
+            if (std::lexicographical_compare(wx.begin(), wx.end(), wy.begin(), wy.end())) return false;
+            return y < x;
+        };
+
+        std::vector<std::uint32_t> heap { arena.allocate(weight_traits<MW>::zero(), src, arena.none) };
+        buckets[src].push_back(heap.front());
+
+        while (!heap.empty()) {
+
+            std::pop_heap(begin(heap), end(heap), lex_greater);
+            const std::uint32_t l = heap.back();
+            heap.pop_back();
+
+            if (arena[l].dead) {
+                continue;
+            }
+
+            const node u = arena[l].at;
+            if (u == dst) {
+                continue;
+            }
+
+            std::for_each(out_begin(t, u), out_end(t, u), [&](node v) {
+                const MW w = arena[l].weight + m(edge(u, v));
+
+                if (!pareto_within(w, cstr)) {
+                    return;
+                }
+
+                for (std::uint32_t x : buckets[dst]) {
+                    if (weakly_dominates(arena[x].weight, w)) {
+                        return;
+                    }
+                }
+
+                auto& bucket = buckets[v];
+                for (std::uint32_t x : bucket) {
+                    if (weakly_dominates(arena[x].weight, w)) {
+                        return;
+                    }
+                }
+
+                for (std::size_t i = 0; i < bucket.size();) {
+                    if (weakly_dominates(w, arena[bucket[i]].weight)) {
+                        arena[bucket[i]].dead = true;
+                        bucket[i] = bucket.back();
+                        bucket.pop_back();
+                    } else {
+                        ++i;
+                    }
+                }
+
+                const std::uint32_t nl = arena.allocate(w, v, l);
+                bucket.push_back(nl);
+                heap.push_back(nl);
+                std::push_heap(begin(heap), end(heap), lex_greater);
+            });
+        }
+    }
+
+    template <MultiWeight MW>
+    path pareto_build_path(const label_arena<MW>& arena, std::uint32_t l)
+    {
+        path result;
+        for (; l != arena.none; l = arena[l].pred) {
+            result.push_front(arena[l].at);
+        }
+        return result;
+    }
+
+}
+
+/// Finds the Pareto frontier of the paths between src and dst, i.e. all
+/// the paths whose weights are not dominated by the weight of any other
+/// path; optionally only the paths fulfilling the constraints are
+/// considered. The paths are ordered lexicographically by their weights
+/// and of the paths of equal weights only one is reported.
+///
+/// @param t The topology,
+/// @param m The multi-weight metric,
+/// @param src The source node,
+/// @param dst The destination node,
+/// @param cstr The upper bounds of the weight components but the first.
+template <class Topology, class Metric>
+std::vector<path> pareto_paths(
+        const Topology& t, const Metric& m, node src, node dst,
+        const std::vector<double>& cstr = {}) {
+
+    using MW = typename Metric::weight_type;
+
+    detail::label_arena<MW> arena;
+    std::vector<std::vector<std::uint32_t>> buckets;
+    detail::pareto_relax(t, m, src, dst, cstr, arena, buckets);
+
+    std::vector<std::uint32_t> frontier = buckets[dst];
+    std::sort(begin(frontier), end(frontier), [&arena](std::uint32_t x, std::uint32_t y) {
+        const MW& wx = arena[x].weight;
+        const MW& wy = arena[y].weight;
+        return std::lexicographical_compare(wx.begin(), wx.end(), wy.begin(), wy.end());
+    });
+
+    std::vector<path> result;
+    for (std::uint32_t l : frontier) {
+        result.push_back(detail::pareto_build_path(arena, l));
+    }
+    return result;
+}
+
+#endif
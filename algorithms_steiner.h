@@ -0,0 +1,250 @@
+#ifndef ALGORITHMS_STEINER_H
+#define ALGORITHMS_STEINER_H
+
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "algorithms_basic.h"
+
+// The Steiner tree heuristic.
+// ===========================
+
+namespace detail {
+
+    /// The multi-source Dijkstra's algorithm partitioning the nodes into the
+    /// Voronoi regions of the terminals, i.e. assigning each node the base
+    /// terminal nearest to it.
+    ///
+    /// @param t The topology,
+    /// @param m The metric,
+    /// @param terminals The sources,
+    /// @param ws The workspace; holds the predecessors towards the bases and
+    ///           the distances from them after the call,
+    /// @param out_base The out parameter returning the base of every node,
+    ///                 or -1 for the nodes unreachable from the terminals,
+    /// @param cmp The weight comparator functor.
+    template <class Topology, class Metric, typename WeightCmp>
+    void voronoi_relax(
+            const Topology& t,
+            const Metric& m,
+            const std::vector<node>& terminals,
+            search_workspace<typename Metric::weight_type>& ws,
+            std::vector<node>& out_base,
+            const WeightCmp& cmp) {
+
+        using W = typename Metric::weight_type;
+        using entry = typename search_workspace<W>::entry;
+
+        ws.reset(terminals.front());
+        out_base.assign(ws.preds.size(), -1);
+
+        auto heap_cmp = [&cmp](const entry& x, const entry& y) {
+            if (cmp(y.first, x.first)) return true;
+            if (cmp(x.first, y.first)) return false;
+            return y.second < x.second;
+        };
+
+        auto& dists = ws.dists;
+        auto& preds = ws.preds;
+        auto& open = ws.open;
+
+        for (node s : terminals) {
+            dists[s] = weight_traits<W>::zero();
+            out_base[s] = s;
+            open.emplace_back(dists[s], s);
+        }
+        std::make_heap(begin(open), end(open), heap_cmp);
+
+        while (!open.empty()) {
+
+            std::pop_heap(begin(open), end(open), heap_cmp);
+            const entry top = open.back();
+            open.pop_back();
+
+            node u = top.second;
+            if (cmp(dists[u], top.first)) {
+                continue;
+            }
+
+            std::for_each(out_begin(t, u), out_end(t, u), [&](node v) {
+                W new_dist = dists[u] + m(edge(u, v));
+                if (cmp(new_dist, dists[v])) {
+                    dists[v] = new_dist;
+                    preds[v] = u;
+                    out_base[v] = out_base[u];
+                    open.emplace_back(new_dist, v);
+                    std::push_heap(begin(open), end(open), heap_cmp);
+                }
+            });
+        }
+    }
+
+    /// Kruskal's selection over the given weighted undirected edges, in the
+    /// order of the weights and then of the keys.
+    template <Weight W, typename Key, typename WeightCmp, typename Select>
+    void kruskal_over(node count, std::vector<std::pair<W, Key>>& candidates, const WeightCmp& cmp, Select select)
+    {
+        std::sort(begin(candidates), end(candidates),
+            [&cmp](const std::pair<W, Key>& x, const std::pair<W, Key>& y) {
+                if (cmp(x.first, y.first)) return true;
+                if (cmp(y.first, x.first)) return false;
+                return x.second < y.second;
+            });
+
+        disjoint_sets sets { count };
+        for (const auto& pr : candidates) {
+            select(sets, pr.second);
+        }
+    }
+
+    /// Removes the non-terminal leaves of the undirected forest repeatedly,
+    /// so that all the remaining leaves are terminals.
+    inline void prune_steiner_leaves(node count, const std::vector<char>& terminal, std::vector<edge>& edges)
+    {
+        std::vector<std::vector<node>> adjacency(count);
+        for (const edge& e : edges) {
+            adjacency[e.first].push_back(e.second);
+            adjacency[e.second].push_back(e.first);
+        }
+
+        std::vector<int> degree(count);
+        std::deque<node> leaves;
+        for (node n = 0; n < count; ++n) {
+            degree[n] = adjacency[n].size();
+            if (degree[n] == 1 && !terminal[n]) {
+                leaves.push_back(n);
+            }
+        }
+
+        std::vector<char> removed(count, false);
+        while (!leaves.empty()) {
+            const node u = leaves.front();
+            leaves.pop_front();
+            removed[u] = true;
+            for (node v : adjacency[u]) {
+                if (!removed[v] && --degree[v] == 1 && !terminal[v]) {
+                    leaves.push_back(v);
+                }
+            }
+        }
+
+        edges.erase(std::remove_if(begin(edges), end(edges),
+            [&removed](const edge& e) { return removed[e.first] || removed[e.second]; }), end(edges));
+    }
+
+}
+
+/// Mehlhorn's 2-approximation of the minimum Steiner tree spanning the given
+/// terminals of a symmetric topology, e.g. for an unconstrained multicast.
+///
+/// A single multi-source search from all the terminals splits the nodes into
+/// the Voronoi regions of the terminals; every edge between two regions
+/// induces an edge between their terminals weighted by the path through it.
+/// The minimum spanning tree of this terminal graph is expanded into the
+/// paths of the topology, spanned again by a minimum spanning tree and
+/// stripped of the non-terminal leaves. All this is O(m log n), unlike a
+/// search per terminal.
+///
+/// @return The tree rooted in the first terminal, or an empty tree if the
+///         terminals are not connected to each other.
+template <class Topology, class Metric, class NodeIt,
+          typename WeightCmp = std::less<typename Metric::weight_type>>
+tree steiner_tree(const Topology& t, const Metric& m, NodeIt first, NodeIt last, const WeightCmp& cmp = WeightCmp {})
+{
+    using W = typename Metric::weight_type;
+
+    std::vector<node> terminals(first, last);
+    if (terminals.empty()) {
+        return {};
+    }
+    const node root = terminals.front();
+    std::sort(begin(terminals), end(terminals));
+    terminals.erase(std::unique(begin(terminals), end(terminals)), end(terminals));
+
+    const node N = max_node(t) + 1;
+    search_workspace<W> ws { N };
+    std::vector<node> base;
+    detail::voronoi_relax(t, m, terminals, ws, base, cmp);
+
+    // The minimum spanning tree of the terminal graph, each of its edges
+    // represented by the edge of the topology between the regions.
+    std::vector<std::pair<W, std::pair<edge, edge>>> bridges;
+    std::for_each(edge_begin(t), edge_end(t), [&](const edge& e) {
+        const node bu = base[e.first], bv = base[e.second];
+        if (bu != -1 && bv != -1 && bu < bv) {
+            bridges.emplace_back(ws.dists[e.first] + m(e) + ws.dists[e.second], std::make_pair(edge(bu, bv), e));
+        }
+    });
+
+    std::vector<edge> expanded;
+    std::size_t joined = 0;
+    detail::kruskal_over(N, bridges, cmp, [&](detail::disjoint_sets& sets, const std::pair<edge, edge>& bridge) {
+        if (!sets.unite(bridge.first.first, bridge.first.second)) {
+            return;
+        }
+        ++joined;
+        const edge& e = bridge.second;
+        expanded.push_back(normalize(e));
+        for (node x : { e.first, e.second }) {
+            for (; ws.preds[x] != x; x = ws.preds[x]) {
+                expanded.push_back(normalize(edge(ws.preds[x], x)));
+            }
+        }
+    });
+
+    if (joined + 1 != terminals.size()) {
+        return {};
+    }
+
+    std::sort(begin(expanded), end(expanded));
+    expanded.erase(std::unique(begin(expanded), end(expanded)), end(expanded));
+
+    // The minimum spanning tree of the expanded subgraph without the leaves
+    // that are not terminals.
+    std::vector<std::pair<W, edge>> weighted;
+    for (const edge& e : expanded) {
+        weighted.emplace_back(m(e), e);
+    }
+    std::vector<edge> edges;
+    detail::kruskal_over(N, weighted, cmp, [&edges](detail::disjoint_sets& sets, const edge& e) {
+        if (sets.unite(e.first, e.second)) {
+            edges.push_back(e);
+        }
+    });
+
+    std::vector<char> terminal(N, false);
+    for (node x : terminals) {
+        terminal[x] = true;
+    }
+    detail::prune_steiner_leaves(N, terminal, edges);
+
+    // Oriented from the root, the children in their order.
+    std::vector<std::vector<node>> adjacency(N);
+    for (const edge& e : edges) {
+        adjacency[e.first].push_back(e.second);
+        adjacency[e.second].push_back(e.first);
+    }
+    for (auto& neighbors : adjacency) {
+        std::sort(begin(neighbors), end(neighbors));
+    }
+    tree result;
+    std::vector<char> visited(N, false);
+    std::deque<node> queue { root };
+    visited[root] = true;
+    while (!queue.empty()) {
+        const node u = queue.front();
+        queue.pop_front();
+        for (node v : adjacency[u]) {
+            if (!visited[v]) {
+                visited[v] = true;
+                result.set(edge(u, v));
+                queue.push_back(v);
+            }
+        }
+    }
+
+    return result;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef ALGORITHMS_YEN_H
+#define ALGORITHMS_YEN_H
+
+#include <vector>
+#include <iterator>
+
+#include "algorithms_basic.h"
+#include "topology_view.h"
+#include "parallel.h"
+
+// The k shortest loopless paths.
+// ==============================
+
+namespace detail {
+
+    /// A path along with the weights of all its prefixes; prefix[i] is the
+    /// weight of the path up to its i-th node.
+    template <Weight W>
+    struct yen_path {
+        std::vector<node> nodes;
+        std::vector<W> prefix;
+    };
+
+    template <class Metric>
+    yen_path<typename Metric::weight_type> yen_make_path(const Metric& m, std::vector<node> nodes)
+    {
+        using W = typename Metric::weight_type;
+        yen_path<W> result { std::move(nodes), { weight_traits<W>::zero() } };
+        for (std::size_t i = 1; i < result.nodes.size(); ++i) {
+            result.prefix.push_back(result.prefix.back() + m(edge(result.nodes[i - 1], result.nodes[i])));
+        }
+        return result;
+    }
+
+}
+
+/// Yen's algorithm for the k shortest loopless paths between src and dst.
+///
+/// The spur searches of an iteration are independent and run on the
+/// workers, each of which reuses a single search workspace and a node mask
+/// of its own. The weights of the root paths are taken from the cached
+/// prefix weights of the accepted paths.
+///
+/// @return Up to k paths in the order of their weights.
+template <class Topology, class Metric, typename WeightCmp = std::less<typename Metric::weight_type>>
+std::vector<path> k_shortest_paths(
+        const Topology& t, const Metric& m, node src, node dst, int k,
+        const WeightCmp& cmp = WeightCmp {}, unsigned threads = 0) {
+
+    using W = typename Metric::weight_type;
+    using candidate = detail::yen_path<W>;
+
+    const node N = max_node(t) + 1;
+    const unsigned workers = detail::worker_count(threads);
+
+    std::vector<candidate> accepted;
+    std::vector<candidate> candidates;
+
+    {
+        search_workspace<W> ws { N };
+        path p;
+        dijkstra(t, m, src, dst, ws, p, cmp);
+        if (p.empty() || k <= 0) {
+            return {};
+        }
+        accepted.push_back(detail::yen_make_path(m, std::vector<node>(begin(p), end(p))));
+    }
+
+    auto cand_less = [&cmp](const candidate& x, const candidate& y) {
+        if (cmp(x.prefix.back(), y.prefix.back())) return true;
+        if (cmp(y.prefix.back(), x.prefix.back())) return false;
+        return x.nodes < y.nodes;
+    };
+
+    auto known = [&accepted, &candidates](const std::vector<node>& nodes) {
+        auto same = [&nodes](const candidate& c) { return c.nodes == nodes; };
+        return std::any_of(begin(accepted), end(accepted), same) ||
+               std::any_of(begin(candidates), end(candidates), same);
+    };
+
+    std::vector<search_workspace<W>> workspaces(workers);
+    std::vector<std::vector<char>> node_masks(workers);
+
+    while (static_cast<int>(accepted.size()) < k) {
+
+        const candidate& last = accepted.back();
+        const std::size_t spurs = last.nodes.size() - 1;
+        std::vector<std::vector<node>> found(spurs);
+
+        detail::parallel_for_each_index(spurs, workers, [&](unsigned w, std::size_t i) {
+            auto& ws = workspaces[w];
+            auto& removed_nodes = node_masks[w];
+            if (removed_nodes.empty()) {
+                ws.resize(N);
+                removed_nodes.resize(N, false);
+            }
+
+            const node spur = last.nodes[i];
+            const auto root_first = begin(last.nodes);
+            const auto root_last = root_first + i + 1;
+
+            // The spur search avoids the nodes of the root path and the
+            // edges leaving the spur node along the already found paths
+            // sharing the root.
+            std::vector<edge> removed_edges;
+            for (const candidate& a : accepted) {
+                if (a.nodes.size() > i + 1 && std::equal(root_first, root_last, begin(a.nodes))) {
+                    removed_edges.emplace_back(spur, a.nodes[i + 1]);
+                }
+            }
+            for (auto it = root_first; it != root_last - 1; ++it) {
+                removed_nodes[*it] = true;
+            }
+
+            const topology_view<Topology> view { t, &removed_nodes, std::move(removed_edges) };
+            path spur_path;
+            dijkstra(view, m, spur, dst, ws, spur_path, cmp);
+
+            for (auto it = root_first; it != root_last - 1; ++it) {
+                removed_nodes[*it] = false;
+            }
+
+            if (!spur_path.empty()) {
+                found[i].assign(root_first, root_last - 1);
+                found[i].insert(end(found[i]), begin(spur_path), end(spur_path));
+            }
+        });
+
+        for (std::size_t i = 0; i < spurs; ++i) {
+            if (found[i].empty() || known(found[i])) {
+                continue;
+            }
+            // Only the spur part needs to be accumulated; the root weight
+            // is the cached prefix.
+            candidate c { std::move(found[i]), { last.prefix.begin(), last.prefix.begin() + i + 1 } };
+            for (std::size_t j = i + 1; j < c.nodes.size(); ++j) {
+                c.prefix.push_back(c.prefix.back() + m(edge(c.nodes[j - 1], c.nodes[j])));
+            }
+            candidates.push_back(std::move(c));
+        }
+
+        if (candidates.empty()) {
+            break;
+        }
+
+        auto best = std::min_element(begin(candidates), end(candidates), cand_less);
+        accepted.push_back(std::move(*best));
+        candidates.erase(best);
+    }
+
+    std::vector<path> result;
+    for (const candidate& c : accepted) {
+        result.emplace_back(begin(c.nodes), end(c.nodes));
+    }
+    return result;
+}
+
+#endif
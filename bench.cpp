@@ -0,0 +1,453 @@
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+#include "weight.h"
+#include "metric.h"
+#include "topology.h"
+#include "weight_util.h"
+#include "algorithms_basic.h"
+#include "algorithms_larac.h"
+#include "algorithms_mlra.h"
+#include "algorithms_steiner.h"
+#include "algorithms_failure.h"
+#include "generators.h"
+#include "topology_compressed.h"
+#include "memory_hook.h"
+
+/// The benchmark suite: every algorithm over every topology, metric and
+/// graph size, reported as JSON records on the standard output.
+///
+/// Usage: top_bench [--sizes 100,1000,...] [--queries N] [--seed S]
+///                  [--algorithms dijkstra,bellman_ford,prim,larac,mlra,larac_tree,steiner,failure]
+///                  [--topologies adj_list,adj_matrix,csr,compressed] [--metrics hop,map]
+///                  [--max-matrix-nodes N] [--max-bellman-ford-nodes N]
+///
+/// The graphs are the generated square grids with random costs and delays;
+/// the csr and compressed topologies are measured with the csr_metric as the
+/// "map" metric. The quadratic
+/// combinations, i.e. adj_matrix and bellman_ford, are skipped above the
+/// given sizes. The relaxations are counted as the edge evaluations of the
+/// metric, in a second untimed pass over the same queries, so that the
+/// counting does not slow the timed one down; the peak memory is the peak resident set of the whole process
+/// so far. The graph memory is its memory_usage() and the query peak is the
+/// greatest peak of the live bytes allocated by the calling thread during a
+/// query, as counted by the hooked operator new; the allocations of the
+/// other workers of mlra are not included.
+
+TOP_COUNTING_OPERATOR_NEW
+
+namespace {
+
+    using W = array_weight<double, 2>;
+
+    /// The count of the edge evaluations, taken only while enabled; the
+    /// flag is not written while the queries are timed.
+    struct evaluation_counter {
+        bool enabled = false;
+        std::atomic<std::uint64_t> count { 0 };
+    };
+
+    /// The metric adaptor counting the edge evaluations, i.e. the edge
+    /// relaxations of the searches.
+    template <class Metric>
+    struct counting_metric {
+
+        using weight_type = typename Metric::weight_type;
+
+        const Metric& m;
+        evaluation_counter& counter;
+
+        weight_type operator()(const edge& e) const
+        {
+            if (counter.enabled) {
+                counter.count.fetch_add(1, std::memory_order_relaxed);
+            }
+            return m(e);
+        }
+    };
+
+    /// A single criterion view of the cost component of a metric.
+    template <class Metric>
+    struct cost_metric {
+
+        using weight_type = double;
+
+        const Metric& m;
+
+        double operator()(const edge& e) const
+        {
+            return m(e)[0];
+        }
+    };
+
+    struct options {
+        std::vector<std::size_t> sizes { 100, 1000, 10000, 100000 };
+        std::size_t queries = 20;
+        std::uint32_t seed = 1;
+        std::vector<std::string> algorithms { "dijkstra", "bellman_ford", "prim", "larac", "mlra", "larac_tree", "steiner", "failure" };
+        std::vector<std::string> topologies { "adj_list", "adj_matrix", "csr", "compressed" };
+        std::vector<std::string> metrics { "hop", "map" };
+        std::size_t max_matrix_nodes = 10000;
+        std::size_t max_bellman_ford_nodes = 1000;
+    };
+
+    std::vector<std::string> split(const std::string& list)
+    {
+        std::vector<std::string> result;
+        std::istringstream in { list };
+        for (std::string item; std::getline(in, item, ',');) {
+            result.push_back(item);
+        }
+        return result;
+    }
+
+    bool contains(const std::vector<std::string>& xs, const std::string& x)
+    {
+        return std::find(begin(xs), end(xs), x) != end(xs);
+    }
+
+    /// The square grid of about n nodes with random symmetric costs and
+    /// delays in [1, 100].
+    void make_grid(std::size_t n, std::uint32_t seed, csr_graph& g, csr_metric<W>& m)
+    {
+        const node side = std::max<node>(2, static_cast<node>(std::sqrt(double(n)) + 0.5));
+        generate_grid(side, side, seed, g, m);
+    }
+
+    /// Copies a generated graph into another topology, built at once, and a
+    /// map_metric.
+    template <class Graph>
+    void copy_graph(const csr_graph& csr, const csr_metric<W>& csr_m, Graph& g, map_metric<W, true>& m)
+    {
+        g.assign(edge_begin(csr), edge_end(csr));
+        std::for_each(edge_begin(csr), edge_end(csr), [&](const edge& e) {
+            if (e.first < e.second) {
+                m(e) = csr_m(e);
+            }
+        });
+    }
+
+    long peak_rss_kb()
+    {
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    struct record {
+        std::string algorithm, topology, metric;
+        std::size_t nodes = 0, edges = 0;
+        std::vector<double> latencies_us;
+        double seconds = 0.0;
+        std::uint64_t relaxations = 0;
+        std::size_t graph_bytes = 0;
+        std::size_t query_peak_bytes = 0;
+    };
+
+    double percentile(std::vector<double> xs, double p)
+    {
+        if (xs.empty()) {
+            return 0.0;
+        }
+        std::sort(begin(xs), end(xs));
+        const std::size_t i = std::min(xs.size() - 1, static_cast<std::size_t>(p / 100.0 * xs.size()));
+        return xs[i];
+    }
+
+    void print(const record& r, bool& first)
+    {
+        const double queries = r.latencies_us.size();
+        std::cout << (first ? "\n" : ",\n") << "  { "
+            << "\"algorithm\": \"" << r.algorithm << "\", "
+            << "\"topology\": \"" << r.topology << "\", "
+            << "\"metric\": \"" << r.metric << "\", "
+            << "\"nodes\": " << r.nodes << ", "
+            << "\"edges\": " << r.edges << ", "
+            << "\"queries\": " << r.latencies_us.size() << ", "
+            << "\"p50_us\": " << percentile(r.latencies_us, 50) << ", "
+            << "\"p90_us\": " << percentile(r.latencies_us, 90) << ", "
+            << "\"p99_us\": " << percentile(r.latencies_us, 99) << ", "
+            << "\"max_us\": " << percentile(r.latencies_us, 100) << ", "
+            << "\"throughput_qps\": " << (r.seconds > 0 ? queries / r.seconds : 0.0) << ", "
+            << "\"relaxations_per_s\": " << (r.seconds > 0 ? r.relaxations / r.seconds : 0.0) << ", "
+            << "\"graph_bytes\": " << r.graph_bytes << ", "
+            << "\"query_peak_bytes\": " << r.query_peak_bytes << ", "
+            << "\"peak_rss_kb\": " << peak_rss_kb() << " }";
+        first = false;
+    }
+
+    /// Runs the queries of one algorithm; query(src, dst) performs one of them.
+    /// The queries are timed uncounted and then repeated with the counting.
+    template <typename Query>
+    void measure(record& r, std::size_t queries, std::uint32_t seed, evaluation_counter& counter, Query query)
+    {
+        std::mt19937 rng { seed };
+        std::uniform_int_distribution<node> pick { 0, static_cast<node>(r.nodes) - 1 };
+        counter.enabled = false;
+        for (std::size_t q = 0; q < queries; ++q) {
+            const node src = pick(rng);
+            const node dst = pick(rng);
+            allocation_counter allocations;
+            const auto start = std::chrono::steady_clock::now();
+            {
+                allocation_scope scope { allocations };
+                query(src, dst, rng);
+            }
+            const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            r.query_peak_bytes = std::max(r.query_peak_bytes, allocations.peak);
+            r.latencies_us.push_back(elapsed.count());
+            r.seconds += elapsed.count() / 1e6;
+        }
+
+        rng.seed(seed);
+        pick.reset();
+        counter.count = 0;
+        counter.enabled = true;
+        for (std::size_t q = 0; q < queries; ++q) {
+            const node src = pick(rng);
+            const node dst = pick(rng);
+            query(src, dst, rng);
+        }
+        counter.enabled = false;
+        r.relaxations = counter.count.load();
+    }
+
+    template <class Graph, class Metric>
+    void run_algorithms(
+            const options& opt, const std::string& topology, const std::string& metric,
+            std::size_t nodes, std::size_t edges, const Graph& g, const Metric& mm, bool& first) {
+
+        evaluation_counter count;
+        const counting_metric<Metric> m { mm, count };
+        const cost_metric<counting_metric<Metric>> cm { m };
+        const node N = max_node(g) + 1;
+
+        auto make = [&](const char* algorithm) {
+            record r;
+            r.algorithm = algorithm;
+            r.topology = topology;
+            r.metric = metric;
+            r.nodes = nodes;
+            r.edges = edges;
+            r.graph_bytes = memory_usage(g).total();
+            return r;
+        };
+
+        if (contains(opt.algorithms, "dijkstra")) {
+            record r = make("dijkstra");
+            search_workspace<double> ws { N };
+            path p;
+            measure(r, opt.queries, opt.seed, count, [&](node src, node dst, std::mt19937&) {
+                dijkstra(g, cm, src, dst, ws, p);
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "bellman_ford") && nodes <= opt.max_bellman_ford_nodes) {
+            record r = make("bellman_ford");
+            measure(r, opt.queries, opt.seed, count, [&](node src, node dst, std::mt19937&) {
+                bellman_ford(g, cm, src, dst);
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "prim")) {
+            record r = make("prim");
+            measure(r, opt.queries, opt.seed, count, [&](node src, node, std::mt19937&) {
+                prim(g, cm, src);
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "larac")) {
+            record r = make("larac");
+            search_workspace<W> ws { N };
+            measure(r, opt.queries, opt.seed, count, [&](node src, node dst, std::mt19937&) {
+                // The constraint is between the delays of the cheapest and
+                // the fastest paths for a typical pair.
+                larac(g, m, 25.0 * std::sqrt(double(nodes)), src, dst, ws);
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "mlra")) {
+            record r = make("mlra");
+            std::uniform_int_distribution<node> pick { 0, N - 1 };
+            measure(r, opt.queries, opt.seed, count, [&](node src, node, std::mt19937& rng) {
+                std::vector<node> dsts(8);
+                for (node& d : dsts) {
+                    d = pick(rng);
+                }
+                mlra(g, m, 25.0 * std::sqrt(double(nodes)), src, begin(dsts), end(dsts));
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "larac_tree")) {
+            record r = make("larac_tree");
+            std::uniform_int_distribution<node> pick { 0, N - 1 };
+            measure(r, opt.queries, opt.seed, count, [&](node src, node, std::mt19937& rng) {
+                std::vector<node> dsts(8);
+                for (node& d : dsts) {
+                    d = pick(rng);
+                }
+                larac_tree(g, m, 25.0 * std::sqrt(double(nodes)), src, begin(dsts), end(dsts));
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "steiner")) {
+            record r = make("steiner");
+            std::uniform_int_distribution<node> pick { 0, N - 1 };
+            measure(r, opt.queries, opt.seed, count, [&](node src, node, std::mt19937& rng) {
+                std::vector<node> terminals { src };
+                for (int i = 0; i < 8; ++i) {
+                    terminals.push_back(pick(rng));
+                }
+                steiner_tree(g, cm, begin(terminals), end(terminals));
+            });
+            print(r, first);
+        }
+
+        if (contains(opt.algorithms, "failure")) {
+            record r = make("failure");
+            std::uniform_int_distribution<node> pick { 0, N - 1 };
+            const std::vector<std::vector<edge>> failures = link_failures(g);
+            measure(r, opt.queries, opt.seed, count, [&](node src, node, std::mt19937& rng) {
+                std::vector<demand> demands;
+                for (int i = 0; i < 8; ++i) {
+                    demands.emplace_back(src, pick(rng));
+                }
+                failure_impact(g, cm, demands, failures);
+            });
+            print(r, first);
+        }
+    }
+
+    template <class Graph>
+    void run_topology(const options& opt, const std::string& topology, std::size_t size, bool& first)
+    {
+        csr_graph csr;
+        csr_metric<W> csr_m;
+        make_grid(size, opt.seed, csr, csr_m);
+
+        Graph g;
+        map_metric<W, true> m;
+        copy_graph(csr, csr_m, g, m);
+
+        const std::size_t nodes = max_node(g) + 1;
+        const std::size_t edges = std::distance(edge_begin(g), edge_end(g));
+
+        if (contains(opt.metrics, "hop")) {
+            run_algorithms(opt, topology, "hop", nodes, edges, g, hop_metric<W> {}, first);
+        }
+        if (contains(opt.metrics, "map")) {
+            run_algorithms(opt, topology, "map", nodes, edges, g, m, first);
+        }
+    }
+
+    /// The compact graph is measured with its own array metric in place of
+    /// the map_metric.
+    template <>
+    void run_topology<csr_graph>(const options& opt, const std::string& topology, std::size_t size, bool& first)
+    {
+        csr_graph g;
+        csr_metric<W> m;
+        make_grid(size, opt.seed, g, m);
+
+        const std::size_t nodes = nodes_count(g);
+        const std::size_t edges = g.edges_count();
+
+        if (contains(opt.metrics, "hop")) {
+            run_algorithms(opt, topology, "hop", nodes, edges, g, hop_metric<W> {}, first);
+        }
+        if (contains(opt.metrics, "map")) {
+            run_algorithms(opt, topology, "csr", nodes, edges, g, m, first);
+        }
+    }
+
+    /// The compressed graph shares the array metric of the graph it is
+    /// compressed from.
+    template <>
+    void run_topology<compressed_graph>(const options& opt, const std::string& topology, std::size_t size, bool& first)
+    {
+        csr_graph csr;
+        csr_metric<W> m;
+        make_grid(size, opt.seed, csr, m);
+        const compressed_graph g { csr };
+
+        const std::size_t nodes = nodes_count(g);
+        const std::size_t edges = csr.edges_count();
+
+        if (contains(opt.metrics, "hop")) {
+            run_algorithms(opt, topology, "hop", nodes, edges, g, hop_metric<W> {}, first);
+        }
+        if (contains(opt.metrics, "map")) {
+            run_algorithms(opt, topology, "csr", nodes, edges, g, m, first);
+        }
+    }
+
+}
+
+int main(int argc, char* argv[])
+{
+    options opt;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string key = argv[i];
+        const std::string value = argv[i + 1];
+        if (key == "--sizes") {
+            opt.sizes.clear();
+            for (const auto& s : split(value)) {
+                opt.sizes.push_back(std::stoull(s));
+            }
+        } else if (key == "--queries") {
+            opt.queries = std::stoull(value);
+        } else if (key == "--seed") {
+            opt.seed = std::stoul(value);
+        } else if (key == "--algorithms") {
+            opt.algorithms = split(value);
+        } else if (key == "--topologies") {
+            opt.topologies = split(value);
+        } else if (key == "--metrics") {
+            opt.metrics = split(value);
+        } else if (key == "--max-matrix-nodes") {
+            opt.max_matrix_nodes = std::stoull(value);
+        } else if (key == "--max-bellman-ford-nodes") {
+            opt.max_bellman_ford_nodes = std::stoull(value);
+        } else {
+            std::cerr << "Unknown option " << key << std::endl;
+            return 1;
+        }
+    }
+
+    bool first = true;
+    std::cout << "[";
+    for (std::size_t size : opt.sizes) {
+        if (contains(opt.topologies, "adj_list")) {
+            run_topology<adj_list>(opt, "adj_list", size, first);
+        }
+        if (contains(opt.topologies, "adj_matrix") && size <= opt.max_matrix_nodes) {
+            run_topology<adj_matrix>(opt, "adj_matrix", size, first);
+        }
+        if (contains(opt.topologies, "csr")) {
+            run_topology<csr_graph>(opt, "csr", size, first);
+        }
+        if (contains(opt.topologies, "compressed")) {
+            run_topology<compressed_graph>(opt, "compressed", size, first);
+        }
+    }
+    std::cout << "\n]" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,297 @@
+#ifndef CONNECTIVITY_INDEX_H
+#define CONNECTIVITY_INDEX_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+#include "config.h"
+#include "memory.h"
+#include "topology.h"
+#include "algorithms_basic.h"
+
+// The connectivity index.
+// =======================
+
+/// The index telling without any search that a node cannot be reached from
+/// another one, e.g. to reject the infeasible queries at once.
+///
+/// The weak components, i.e. of the edges taken as undirected, are kept in
+/// a disjoint sets forest; the strong components are numbered by Tarjan's
+/// algorithm, which completes a component only after all the components it
+/// reaches, so that a node only reaches the nodes of the same or a lower
+/// numbered component. Hence dst is unreachable from src if they are in
+/// different weak components, or if the component of src is numbered below
+/// that of dst.
+///
+/// Adding an edge merges the weak components in a nearly constant time. The
+/// numbering of the strong components stays valid for an edge from a higher
+/// to a lower numbered component or within a component; any other edge may
+/// merge the components, so that the numbering is invalidated until the
+/// index is rebuilt, and only the weak components are consulted meanwhile.
+/// The new isolated nodes, which reach nothing, are numbered below all the
+/// components, so that an edge to a new node keeps the numbering valid,
+/// e.g. when a graph is loaded edge by edge in the order of a traversal.
+/// The queries do not modify the index, so that they may run concurrently.
+class connectivity_index {
+
+    detail::disjoint_sets m_weak;
+    std::vector<node> m_strong;
+    node m_strong_min = 0;
+    bool m_strong_valid = true;
+
+    void grow(node count)
+    {
+        m_weak.grow(count);
+        // The new isolated nodes take components of their own, below all.
+        while (static_cast<node>(m_strong.size()) < count) {
+            m_strong.push_back(--m_strong_min);
+        }
+    }
+
+    bool contains(node x) const
+    {
+        return x >= 0 && x < static_cast<node>(m_strong.size());
+    }
+
+public:
+    connectivity_index() = default;
+
+    template <class Topology>
+    explicit connectivity_index(const Topology& t)
+    {
+        rebuild(t);
+    }
+
+    /// Indexes the topology from scratch, in O(n + m).
+    template <class Topology>
+    void rebuild(const Topology& t)
+    {
+        using impl_out_iterator = decltype(out_begin(t, node {}));
+
+        const node N = edge_begin(t) == edge_end(t) ? 0 : max_node(t) + 1;
+
+        m_weak = detail::disjoint_sets { N };
+        std::for_each(edge_begin(t), edge_end(t), [this](const edge& e) {
+            m_weak.unite(e.first, e.second);
+        });
+
+        // The iterative Tarjan's algorithm.
+        struct frame {
+            node u;
+            impl_out_iterator next, last;
+        };
+        std::vector<int> index(N, -1), low(N, 0);
+        std::vector<char> on_stack(N, false);
+        std::vector<node> stack;
+        std::vector<frame> frames;
+        int counter = 0;
+        node components = 0;
+
+        m_strong.assign(N, -1);
+        m_strong_min = 0;
+
+        for (node r = 0; r < N; ++r) {
+            if (index[r] != -1) {
+                continue;
+            }
+            index[r] = low[r] = counter++;
+            stack.push_back(r);
+            on_stack[r] = true;
+            frames.push_back({ r, out_begin(t, r), out_end(t, r) });
+
+            while (!frames.empty()) {
+                frame& f = frames.back();
+                const node u = f.u;
+                if (f.next != f.last) {
+                    const node v = *f.next;
+                    ++f.next;
+                    if (index[v] == -1) {
+                        index[v] = low[v] = counter++;
+                        stack.push_back(v);
+                        on_stack[v] = true;
+                        frames.push_back({ v, out_begin(t, v), out_end(t, v) });
+                    } else if (on_stack[v]) {
+                        low[u] = std::min(low[u], index[v]);
+                    }
+                    continue;
+                }
+
+                frames.pop_back();
+                if (!frames.empty()) {
+                    const node parent = frames.back().u;
+                    low[parent] = std::min(low[parent], low[u]);
+                }
+                if (low[u] == index[u]) {
+                    node x;
+                    do {
+                        x = stack.back();
+                        stack.pop_back();
+                        on_stack[x] = false;
+                        m_strong[x] = components;
+                    } while (x != u);
+                    ++components;
+                }
+            }
+        }
+
+        m_strong_valid = true;
+    }
+
+    /// Takes a new edge into account.
+    void add(const edge& e)
+    {
+        grow(std::max(e.first, e.second) + 1);
+        m_weak.unite(e.first, e.second);
+        if (m_strong[e.first] < m_strong[e.second]) {
+            m_strong_valid = false;
+        }
+    }
+
+    /// True if the strong components are up to date.
+    bool strong_valid() const
+    {
+        return m_strong_valid;
+    }
+
+    bool weakly_connected(node u, node v) const
+    {
+        if (u == v) {
+            return true;
+        }
+        return contains(u) && contains(v) && m_weak.root(u) == m_weak.root(v);
+    }
+
+    /// True if the nodes reach each other; as the added edges never split
+    /// the components, this holds even if the numbering is out of date,
+    /// though the nodes joined since the rebuild are not recognized.
+    bool strongly_connected(node u, node v) const
+    {
+        if (u == v) {
+            return true;
+        }
+        return contains(u) && contains(v) && m_strong[u] == m_strong[v];
+    }
+
+    /// True if dst is certainly not reachable from src.
+    bool unreachable(node src, node dst) const
+    {
+        if (src == dst) {
+            return false;
+        }
+        if (!weakly_connected(src, dst)) {
+            return true;
+        }
+        return m_strong_valid && m_strong[src] < m_strong[dst];
+    }
+
+    friend memory_footprint memory_usage(const connectivity_index& x)
+    {
+        return memory_usage(x.m_weak) + detail::vector_footprint(x.m_strong);
+    }
+};
+
+/// The graph keeping a connectivity index along, so that the algorithms
+/// reject the queries of the unreachable destinations without any search.
+///
+/// The index follows every set() of an edge; the assign() of many edges at
+/// once rebuilds it. The edges merging the strong components leave only the
+/// weak components in use until refresh() is called, e.g. after a batch of
+/// the modifications.
+///
+/// @tparam Graph The underlying graph, e.g. adj_list.
+template <class Graph>
+class indexed_graph {
+
+    Graph m_graph;
+    connectivity_index m_index;
+
+public:
+    indexed_graph() = default;
+
+    explicit indexed_graph(Graph g) : m_graph(std::move(g)), m_index(m_graph) {}
+
+    // Regular:
+    friend bool operator==(const indexed_graph& x, const indexed_graph& y)
+    {
+        return x.m_graph == y.m_graph;
+    }
+
+    friend bool operator!=(const indexed_graph& x, const indexed_graph& y)
+    {
+        return !(x == y);
+    }
+
+    const Graph& graph() const { return m_graph; }
+    const connectivity_index& index() const { return m_index; }
+
+    // Graph operations:
+    void set(const edge& e)
+    {
+        m_graph.set(e);
+        m_index.add(e);
+    }
+
+    template <typename EdgeIt>
+    void assign(EdgeIt first, EdgeIt last)
+    {
+        m_graph.assign(first, last);
+        m_index.rebuild(m_graph);
+    }
+
+    /// Renumbers the strong components if any edge has invalidated them.
+    void refresh()
+    {
+        if (!m_index.strong_valid()) {
+            m_index.rebuild(m_graph);
+        }
+    }
+
+    friend std::size_t version(const indexed_graph& g)
+    {
+        return version(g.m_graph);
+    }
+
+    friend memory_footprint memory_usage(const indexed_graph& g)
+    {
+        return memory_usage(g.m_graph) + memory_usage(g.m_index);
+    }
+
+    friend bool known_unreachable(const indexed_graph& g, node src, node dst)
+    {
+        return g.m_index.unreachable(src, dst);
+    }
+
+    // Topology operations:
+    friend int nodes_count(const indexed_graph& g)
+    {
+        return nodes_count(g.m_graph);
+    }
+
+    friend node max_node(const indexed_graph& g)
+    {
+        return max_node(g.m_graph);
+    }
+
+    friend auto out_begin(const indexed_graph& g, node x) -> decltype(out_begin(g.m_graph, x))
+    {
+        return out_begin(g.m_graph, x);
+    }
+
+    friend auto out_end(const indexed_graph& g, node x) -> decltype(out_end(g.m_graph, x))
+    {
+        return out_end(g.m_graph, x);
+    }
+
+    friend auto edge_begin(const indexed_graph& g) -> decltype(edge_begin(g.m_graph))
+    {
+        return edge_begin(g.m_graph);
+    }
+
+    friend auto edge_end(const indexed_graph& g) -> decltype(edge_end(g.m_graph))
+    {
+        return edge_end(g.m_graph);
+    }
+};
+
+#endif
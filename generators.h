@@ -0,0 +1,362 @@
+#ifndef GENERATORS_H
+#define GENERATORS_H
+
+#include <cmath>
+#include <vector>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <algorithm>
+
+#include "config.h"
+#include "weight.h"
+#include "topology_csr.h"
+#include "parallel.h"
+
+// The synthetic topology generators.
+// ==================================
+//
+// All the generators build undirected graphs directly into a csr_graph and
+// its csr_metric. Every random decision is a hash of the seed and of the
+// nodes or edges it concerns, so the result only depends on the seed and
+// the parameters, never on the number of workers. The work is split into
+// blocks of consecutive nodes, whose edges are concatenated in the order
+// of the blocks.
+//
+// The weight components are the uniformly random integers in [1, 100]; in
+// the geometric families (Waxman and the random geometric graphs) all the
+// components but the first are the Euclidean lengths of the edges scaled to
+// the same range, so that they behave as delays.
+
+namespace detail {
+
+    /// The SplitMix64 finalizer.
+    inline std::uint64_t gen_mix(std::uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    inline std::uint64_t gen_hash(std::uint64_t seed, std::uint64_t a, std::uint64_t b = 0, std::uint64_t c = 0)
+    {
+        return gen_mix(gen_mix(gen_mix(seed ^ gen_mix(a)) ^ b) ^ c);
+    }
+
+    /// The uniform double in [0, 1) given by a hash.
+    inline double gen_unit(std::uint64_t h)
+    {
+        return (h >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /// The sequential generator of a single stream, e.g. of a row of the
+    /// adjacency matrix.
+    struct gen_stream {
+
+        std::uint64_t state;
+
+        std::uint64_t next() { return gen_mix(state += 0x9e3779b97f4a7c15ull); }
+
+        double unit() { return gen_unit(next()); }
+    };
+
+    /// A point of the unit square of the given node.
+    inline std::pair<double, double> gen_point(std::uint64_t seed, node u)
+    {
+        return { gen_unit(gen_hash(seed, u, 1)), gen_unit(gen_hash(seed, u, 2)) };
+    }
+
+    inline double gen_distance(const std::pair<double, double>& p, const std::pair<double, double>& q)
+    {
+        return std::hypot(p.first - q.first, p.second - q.second);
+    }
+
+    /// The number of the nodes per block of work; the blocks are formed
+    /// independently of the number of the workers.
+    const std::size_t gen_block = 1 << 12;
+
+    /// Runs f(first, last, out_edges) for the blocks of nodes of [0, count)
+    /// and concatenates the edges in the order of the blocks.
+    template <typename F>
+    std::vector<edge> gen_edges(std::size_t count, unsigned threads, F f)
+    {
+        const std::size_t blocks = (count + gen_block - 1) / gen_block;
+        std::vector<std::vector<edge>> parts(blocks);
+        parallel_for_each_index(blocks, worker_count(threads), [&](unsigned, std::size_t b) {
+            f(b * gen_block, std::min(count, (b + 1) * gen_block), parts[b]);
+        });
+
+        std::size_t total = 0;
+        for (const auto& part : parts) {
+            total += part.size();
+        }
+        std::vector<edge> result;
+        result.reserve(total);
+        for (auto& part : parts) {
+            result.insert(result.end(), part.begin(), part.end());
+            std::vector<edge>().swap(part);
+        }
+        return result;
+    }
+
+    /// Builds the symmetric graph of the edges and assigns the weights; the
+    /// weight of an edge is a hash of its normalized endpoints, hence the
+    /// metric is symmetric. The geometric functor may then override the
+    /// delays.
+    template <MultiWeight MW, typename F>
+    void gen_build(
+            node node_count, const std::vector<edge>& edges, std::uint64_t seed,
+            csr_graph& out_g, csr_metric<MW>& out_m, unsigned threads, F geometric) {
+
+        out_g = csr_graph { node_count, edges, true, threads };
+        out_m = csr_metric<MW> { out_g };
+        out_m.assign([seed, &geometric](node u, node v) {
+            if (v < u) {
+                std::swap(u, v);
+            }
+            MW w = weight_traits<MW>::zero();
+            for (int i = 0; i < MW::weight_count; ++i) {
+                w.begin()[i] = 1 + gen_hash(seed, u, v, i + 3) % 100;
+            }
+            geometric(u, v, w);
+            return w;
+        }, threads);
+    }
+
+    /// The delays of the geometric families.
+    struct gen_geometric_delays {
+
+        std::uint64_t seed;
+
+        template <MultiWeight MW>
+        void operator()(node u, node v, MW& w) const
+        {
+            const double length = gen_distance(gen_point(seed, u), gen_point(seed, v)) / std::sqrt(2.0);
+            for (int i = 1; i < MW::weight_count; ++i) {
+                w.begin()[i] = std::max(1.0, std::ceil(100.0 * length));
+            }
+        }
+    };
+
+    struct gen_no_geometry {
+        template <MultiWeight MW>
+        void operator()(node, node, MW&) const {}
+    };
+
+}
+
+/// The width x height grid; the node (x, y) is y * width + x and is
+/// connected to its horizontal and vertical neighbors.
+template <MultiWeight MW>
+void generate_grid(
+        node width, node height, std::uint64_t seed,
+        csr_graph& out_g, csr_metric<MW>& out_m, unsigned threads = 0) {
+
+    const auto edges = detail::gen_edges(width * height, threads,
+        [width, height](std::size_t first, std::size_t last, std::vector<edge>& out) {
+            for (node u = first; u < static_cast<node>(last); ++u) {
+                const node x = u % width;
+                const node y = u / width;
+                if (x + 1 < width) {
+                    out.emplace_back(u, u + 1);
+                }
+                if (y + 1 < height) {
+                    out.emplace_back(u, u + width);
+                }
+            }
+        });
+
+    detail::gen_build(width * height, edges, seed, out_g, out_m, threads, detail::gen_no_geometry {});
+}
+
+/// The Erdős–Rényi graph G(n, p): every pair of the nodes is connected with
+/// the probability p. The pairs of a row are visited by geometric skipping,
+/// so the time is proportional to the number of the edges.
+template <MultiWeight MW>
+void generate_erdos_renyi(
+        node n, double p, std::uint64_t seed,
+        csr_graph& out_g, csr_metric<MW>& out_m, unsigned threads = 0) {
+
+    const auto edges = detail::gen_edges(n, threads,
+        [n, p, seed](std::size_t first, std::size_t last, std::vector<edge>& out) {
+            if (p <= 0.0) {
+                return;
+            }
+            const double log_q = std::log1p(-std::min(p, 1.0 - 1e-16));
+            for (node u = first; u < static_cast<node>(last); ++u) {
+                detail::gen_stream rng { detail::gen_hash(seed, u) };
+                for (double v = u;;) {
+                    v += p >= 1.0 ? 1.0 : 1.0 + std::floor(std::log1p(-rng.unit()) / log_q);
+                    if (v >= n) {
+                        break;
+                    }
+                    out.emplace_back(u, static_cast<node>(v));
+                }
+            }
+        });
+
+    detail::gen_build(n, edges, seed, out_g, out_m, threads, detail::gen_no_geometry {});
+}
+
+/// The Barabási–Albert preferential attachment graph: the nodes [0, m] form
+/// a clique, every further node attaches by m edges to the earlier nodes
+/// chosen with the probability proportional to their degrees.
+///
+/// The endpoints are sampled as in the parallel method of Sanders and
+/// Schulz: an edge picks uniformly one of the endpoints of the edges of the
+/// earlier nodes, and a picked target is itself resolved by the hash, so
+/// the edges are independent of each other. A node choosing the same target
+/// twice keeps a single edge.
+template <MultiWeight MW>
+void generate_barabasi_albert(
+        node n, node m, std::uint64_t seed,
+        csr_graph& out_g, csr_metric<MW>& out_m, unsigned threads = 0) {
+
+    m = std::max<node>(1, std::min(m, n - 1));
+    const std::uint64_t clique = std::uint64_t(m) * (m + 1) / 2;
+
+    // The endpoints of the clique edges, in the lexicographic order.
+    std::vector<edge> clique_edges;
+    for (node a = 0; a <= m; ++a) {
+        for (node b = a + 1; b <= m; ++b) {
+            clique_edges.emplace_back(a, b);
+        }
+    }
+
+    auto source = [&clique_edges, clique, m](std::uint64_t j) -> node {
+        return j < clique ? clique_edges[j].first : static_cast<node>(m + 1 + (j - clique) / m);
+    };
+
+    // The j-th edge may only pick among the edges of the earlier nodes.
+    auto first_edge_of = [clique, m](node v) -> std::uint64_t {
+        return clique + std::uint64_t(v - m - 1) * m;
+    };
+
+    // The target of the j-th edge.
+    auto resolve = [&](std::uint64_t j) -> node {
+        for (;;) {
+            if (j < clique) {
+                return clique_edges[j].second;
+            }
+            const node v = source(j);
+            const std::uint64_t earlier = first_edge_of(v);
+            const std::uint64_t r = detail::gen_hash(seed, j) % (2 * earlier);
+            if (r % 2) {
+                return source(r / 2);
+            }
+            j = r / 2;
+        }
+    };
+
+    const auto edges = detail::gen_edges(n, threads,
+        [&](std::size_t first, std::size_t last, std::vector<edge>& out) {
+            std::vector<node> chosen;
+            for (node v = first; v < static_cast<node>(last); ++v) {
+                if (v <= m) {
+                    for (node a = 0; a < v; ++a) {
+                        out.emplace_back(a, v);
+                    }
+                    continue;
+                }
+                chosen.clear();
+                for (node k = 0; k < m; ++k) {
+                    chosen.push_back(resolve(first_edge_of(v) + k));
+                }
+                std::sort(begin(chosen), end(chosen));
+                chosen.erase(std::unique(begin(chosen), end(chosen)), end(chosen));
+                for (node t : chosen) {
+                    out.emplace_back(t, v);
+                }
+            }
+        });
+
+    detail::gen_build(n, edges, seed, out_g, out_m, threads, detail::gen_no_geometry {});
+}
+
+/// The Waxman graph: the nodes are placed uniformly in the unit square and
+/// the nodes at the distance d are connected with the probability
+/// alpha * exp(-d / (beta * L)), where L is the diagonal. All the pairs are
+/// considered, hence the time is quadratic in the number of the nodes.
+template <MultiWeight MW>
+void generate_waxman(
+        node n, double alpha, double beta, std::uint64_t seed,
+        csr_graph& out_g, csr_metric<MW>& out_m, unsigned threads = 0) {
+
+    const double scale = beta * std::sqrt(2.0);
+    std::vector<std::pair<double, double>> points(n);
+    for (node u = 0; u < n; ++u) {
+        points[u] = detail::gen_point(seed, u);
+    }
+
+    const auto edges = detail::gen_edges(n, threads,
+        [&](std::size_t first, std::size_t last, std::vector<edge>& out) {
+            for (node u = first; u < static_cast<node>(last); ++u) {
+                detail::gen_stream rng { detail::gen_hash(seed, u) };
+                for (node v = u + 1; v < n; ++v) {
+                    const double d = detail::gen_distance(points[u], points[v]);
+                    if (rng.unit() < alpha * std::exp(-d / scale)) {
+                        out.emplace_back(u, v);
+                    }
+                }
+            }
+        });
+
+    detail::gen_build(n, edges, seed, out_g, out_m, threads, detail::gen_geometric_delays { seed });
+}
+
+/// The random geometric graph: the nodes are placed uniformly in the unit
+/// square and the nodes closer than the radius are connected. The pairs are
+/// found through a grid of cells of the size of the radius.
+template <MultiWeight MW>
+void generate_random_geometric(
+        node n, double radius, std::uint64_t seed,
+        csr_graph& out_g, csr_metric<MW>& out_m, unsigned threads = 0) {
+
+    // The cells are at least as large as the radius and at most about as
+    // many as the nodes.
+    const node cells = std::max<node>(1, std::min<node>(
+        static_cast<node>(1.0 / radius), static_cast<node>(std::sqrt(double(n))) + 1));
+    std::vector<std::pair<double, double>> points(n);
+    std::vector<std::size_t> cell_offsets(std::size_t(cells) * cells + 1, 0);
+    std::vector<node> cell_nodes(n);
+
+    auto cell_of = [cells](double x) {
+        return std::min<node>(cells - 1, static_cast<node>(x * cells));
+    };
+
+    for (node u = 0; u < n; ++u) {
+        points[u] = detail::gen_point(seed, u);
+        ++cell_offsets[cell_of(points[u].second) * cells + cell_of(points[u].first) + 1];
+    }
+    std::partial_sum(begin(cell_offsets), end(cell_offsets), begin(cell_offsets));
+    {
+        std::vector<std::size_t> cursor(begin(cell_offsets), end(cell_offsets) - 1);
+        for (node u = 0; u < n; ++u) {
+            cell_nodes[cursor[cell_of(points[u].second) * cells + cell_of(points[u].first)]++] = u;
+        }
+    }
+
+    const auto edges = detail::gen_edges(n, threads,
+        [&](std::size_t first, std::size_t last, std::vector<edge>& out) {
+            for (node u = first; u < static_cast<node>(last); ++u) {
+                const node cx = cell_of(points[u].first);
+                const node cy = cell_of(points[u].second);
+                for (node y = std::max(0, cy - 1); y <= std::min(cells - 1, cy + 1); ++y) {
+                    for (node x = std::max(0, cx - 1); x <= std::min(cells - 1, cx + 1); ++x) {
+                        const std::size_t c = std::size_t(y) * cells + x;
+                        for (std::size_t i = cell_offsets[c]; i < cell_offsets[c + 1]; ++i) {
+                            const node v = cell_nodes[i];
+                            if (u < v && detail::gen_distance(points[u], points[v]) < radius) {
+                                out.emplace_back(u, v);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+
+    detail::gen_build(n, edges, seed, out_g, out_m, threads, detail::gen_geometric_delays { seed });
+}
+
+#endif
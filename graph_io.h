@@ -0,0 +1,69 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include <istream>
+#include <stdexcept>
+
+#include "config.h"
+
+/// Reads an undirected graph and its metric from the text format:
+/// one edge per line, "u v w0 w1 ... wk" with the weight components in
+/// order; the missing trailing components are zero. The empty lines and the
+/// lines starting with '#' are skipped. Both directions of every edge are
+/// set in the topology, each once; the topology is built in a single pass
+/// over the file, together with the edges it already holds.
+///
+/// @param in The input stream,
+/// @param g The graph to be filled,
+/// @param m The multi-weight metric to be filled.
+/// @throws std::runtime_error on a malformed line.
+template <class Graph, class Metric>
+void load_graph(std::istream& in, Graph& g, Metric& m)
+{
+    using MW = typename Metric::weight_type;
+
+    std::vector<edge> edges(edge_begin(g), edge_end(g));
+    std::string line;
+    std::size_t number = 0;
+    while (std::getline(in, line)) {
+        ++number;
+        const auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+
+        std::istringstream fields { line };
+        long long u, v;
+        if (!(fields >> u >> v) || u < 0 || v < 0) {
+            throw std::runtime_error("Malformed edge at line " + std::to_string(number) + ".");
+        }
+
+        MW w = weight_traits<MW>::zero();
+        double x;
+        int i = 0;
+        for (; fields >> x; ++i) {
+            if (i == MW::weight_count) {
+                throw std::runtime_error("Too many weights at line " + std::to_string(number) + ".");
+            }
+            w.begin()[i] = x;
+        }
+        if (!fields.eof()) {
+            throw std::runtime_error("Malformed weight at line " + std::to_string(number) + ".");
+        }
+
+        const edge e { static_cast<node>(u), static_cast<node>(v) };
+        edges.push_back(e);
+        edges.push_back(reverse(e));
+        m(e) = w;
+    }
+
+    std::sort(begin(edges), end(edges));
+    edges.erase(std::unique(begin(edges), end(edges)), end(edges));
+    g.assign(begin(edges), end(edges));
+}
+
+#endif
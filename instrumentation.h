@@ -0,0 +1,97 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstdint>
+
+#if 0
+concept SearchStats : Semiregular {
+    void settled();         // a node taken from the frontier for good
+    void relaxed();         // an edge examined
+    void improved();        // an edge improving the distance of its target
+    void pushed();          // a frontier insertion
+    void popped();          // a frontier removal, including the stale ones
+    void looked_up();       // a metric evaluation
+    void compared();        // a weight comparator invocation
+    void iterated();        // a LARAC approximation iteration
+    void merge(const SearchStats&);
+}
+#endif
+
+/// The instrumentation policy doing nothing; all its hooks are empty inline
+/// functions, so an algorithm instrumented by it compiles to the same code
+/// as an uninstrumented one.
+struct no_stats {
+    void settled() {}
+    void relaxed() {}
+    void improved() {}
+    void pushed() {}
+    void popped() {}
+    void looked_up() {}
+    void compared() {}
+    void iterated() {}
+    void merge(const no_stats&) {}
+};
+
+/// The counters of the search events.
+struct search_counters {
+    std::uint64_t nodes_settled = 0;
+    std::uint64_t edges_relaxed = 0;
+    std::uint64_t relaxations_improved = 0;
+    std::uint64_t frontier_pushes = 0;
+    std::uint64_t frontier_pops = 0;
+    std::uint64_t metric_lookups = 0;
+    std::uint64_t comparisons = 0;
+    std::uint64_t larac_iterations = 0;
+
+    search_counters& operator+=(const search_counters& x)
+    {
+        nodes_settled += x.nodes_settled;
+        edges_relaxed += x.edges_relaxed;
+        relaxations_improved += x.relaxations_improved;
+        frontier_pushes += x.frontier_pushes;
+        frontier_pops += x.frontier_pops;
+        metric_lookups += x.metric_lookups;
+        comparisons += x.comparisons;
+        larac_iterations += x.larac_iterations;
+        return *this;
+    }
+
+    friend bool operator==(const search_counters& x, const search_counters& y)
+    {
+        return x.nodes_settled == y.nodes_settled &&
+            x.edges_relaxed == y.edges_relaxed &&
+            x.relaxations_improved == y.relaxations_improved &&
+            x.frontier_pushes == y.frontier_pushes &&
+            x.frontier_pops == y.frontier_pops &&
+            x.metric_lookups == y.metric_lookups &&
+            x.comparisons == y.comparisons &&
+            x.larac_iterations == y.larac_iterations;
+    }
+
+    friend bool operator!=(const search_counters& x, const search_counters& y) { return !(x == y); }
+};
+
+/// The instrumentation policy counting the search events in plain counters.
+/// An object is meant to be used by a single thread, e.g. for a single
+/// query; the multi-threaded algorithms count in an object per worker and
+/// merge them into the given one at the end. The objects of the different
+/// queries or threads are aggregated by merge.
+struct counting_stats {
+
+    search_counters counters;
+
+    void settled() { ++counters.nodes_settled; }
+    void relaxed() { ++counters.edges_relaxed; }
+    void improved() { ++counters.relaxations_improved; }
+    void pushed() { ++counters.frontier_pushes; }
+    void popped() { ++counters.frontier_pops; }
+    void looked_up() { ++counters.metric_lookups; }
+    void compared() { ++counters.comparisons; }
+    void iterated() { ++counters.larac_iterations; }
+
+    void merge(const counting_stats& x) { counters += x.counters; }
+
+    void reset() { counters = {}; }
+};
+
+#endif
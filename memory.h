@@ -0,0 +1,218 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <map>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <algorithm>
+
+/// The dynamic memory owned by a structure, split into the bytes of the
+/// stored values, the bookkeeping of the containers and the allocator, and
+/// the allocated but unused capacity. The object itself, e.g. the header of
+/// a std::vector, is not included, only what it owns; the structures nested
+/// in the owned memory are accounted as overhead.
+struct memory_footprint {
+
+    std::size_t payload = 0;
+    std::size_t overhead = 0;
+    std::size_t slack = 0;
+
+    std::size_t total() const
+    {
+        return payload + overhead + slack;
+    }
+
+    memory_footprint& operator+=(const memory_footprint& x)
+    {
+        payload += x.payload;
+        overhead += x.overhead;
+        slack += x.slack;
+        return *this;
+    }
+
+    friend memory_footprint operator+(memory_footprint x, const memory_footprint& y)
+    {
+        return x += y;
+    }
+
+    friend bool operator==(const memory_footprint& x, const memory_footprint& y)
+    {
+        return x.payload == y.payload && x.overhead == y.overhead && x.slack == y.slack;
+    }
+
+    friend bool operator!=(const memory_footprint& x, const memory_footprint& y) { return !(x == y); }
+};
+
+namespace detail {
+
+    /// The estimated bookkeeping of the allocator for a block of the given
+    /// size, modelled after glibc's malloc: a size word per chunk, chunks
+    /// rounded up to 16 bytes, at least 32 bytes each.
+    inline std::size_t heap_block_overhead(std::size_t bytes)
+    {
+        if (bytes == 0) {
+            return 0;
+        }
+        const std::size_t chunk = std::max<std::size_t>(32, (bytes + sizeof(std::size_t) + 15) & ~std::size_t { 15 });
+        return chunk - bytes;
+    }
+
+    template <typename T, typename A>
+    memory_footprint vector_footprint(const std::vector<T, A>& v)
+    {
+        memory_footprint result;
+        result.payload = v.size() * sizeof(T);
+        result.slack = (v.capacity() - v.size()) * sizeof(T);
+        result.overhead = heap_block_overhead(v.capacity() * sizeof(T));
+        return result;
+    }
+
+    /// The bits are packed into words, the payload is rounded up to bytes.
+    template <typename A>
+    memory_footprint vector_footprint(const std::vector<bool, A>& v)
+    {
+        const std::size_t word = sizeof(unsigned long);
+        const std::size_t bytes = (v.capacity() + 8 * word - 1) / (8 * word) * word;
+        memory_footprint result;
+        result.payload = (v.size() + 7) / 8;
+        result.slack = bytes - result.payload;
+        result.overhead = heap_block_overhead(bytes);
+        return result;
+    }
+
+    /// The red-black tree nodes, each holding the color, three links and the
+    /// value, are allocated one by one.
+    template <typename Map>
+    memory_footprint map_footprint(const Map& m)
+    {
+        using value_type = typename Map::value_type;
+        const std::size_t header = 4 * sizeof(void*);
+        memory_footprint result;
+        result.payload = m.size() * sizeof(value_type);
+        result.overhead = m.size() * (header + heap_block_overhead(header + sizeof(value_type)));
+        return result;
+    }
+
+    /// The deque stores the values in 512 byte blocks (or single values if
+    /// larger) addressed by a map of block pointers, of at least eight.
+    template <typename T, typename A>
+    memory_footprint deque_footprint(const std::deque<T, A>& d)
+    {
+        const std::size_t per_block = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+        const std::size_t block = per_block * sizeof(T);
+        const std::size_t blocks = d.size() / per_block + 1;
+        const std::size_t map = std::max<std::size_t>(8, blocks + 2) * sizeof(T*);
+        memory_footprint result;
+        result.payload = d.size() * sizeof(T);
+        result.slack = blocks * block - result.payload;
+        result.overhead = map + heap_block_overhead(map) + blocks * heap_block_overhead(block);
+        return result;
+    }
+
+}
+
+/// The counter of the bytes allocated and deallocated through it, keeping
+/// the peak of the live bytes. Meant to be used by a single thread.
+struct allocation_counter {
+
+    std::size_t current = 0;
+    std::size_t peak = 0;
+    std::size_t allocations = 0;
+
+    void allocated(std::size_t bytes)
+    {
+        current += bytes;
+        ++allocations;
+        if (current > peak) {
+            peak = current;
+        }
+    }
+
+    void deallocated(std::size_t bytes)
+    {
+        current -= std::min(bytes, current);
+    }
+
+    /// Starts a new measurement; the peak restarts at the live bytes.
+    void reset()
+    {
+        peak = current;
+        allocations = 0;
+    }
+};
+
+/// The allocator counting its allocations in an allocation_counter, e.g.
+/// to measure the peak of the containers used by a query.
+///
+/// @tparam T The allocated type.
+template <typename T>
+struct counting_allocator {
+
+    typedef T value_type;
+
+    allocation_counter* counter;
+
+    explicit counting_allocator(allocation_counter& c) : counter { &c } {}
+
+    template <typename U>
+    counting_allocator(const counting_allocator<U>& x) : counter { x.counter } {}
+
+    T* allocate(std::size_t n)
+    {
+        counter->allocated(n * sizeof(T));
+        return std::allocator<T> {}.allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n)
+    {
+        counter->deallocated(n * sizeof(T));
+        std::allocator<T> {}.deallocate(p, n);
+    }
+
+    template <typename U>
+    friend bool operator==(const counting_allocator& x, const counting_allocator<U>& y) { return x.counter == y.counter; }
+
+    template <typename U>
+    friend bool operator!=(const counting_allocator& x, const counting_allocator<U>& y) { return !(x == y); }
+};
+
+namespace detail {
+
+    /// The counter receiving the allocations of the current thread made by
+    /// the global operator new, if hooked by TOP_COUNTING_OPERATOR_NEW of
+    /// memory_hook.h.
+    inline allocation_counter*& thread_allocation_counter()
+    {
+        static thread_local allocation_counter* counter = nullptr;
+        return counter;
+    }
+
+}
+
+/// Directs the global allocations of the current thread into the given
+/// counter for the lifetime of the scope, e.g. for a single query. It only
+/// counts in a program whose single translation unit expands the
+/// TOP_COUNTING_OPERATOR_NEW hook of memory_hook.h.
+class allocation_scope {
+
+    allocation_counter* m_previous;
+
+public:
+    explicit allocation_scope(allocation_counter& counter) :
+        m_previous { detail::thread_allocation_counter() }
+    {
+        detail::thread_allocation_counter() = &counter;
+    }
+
+    ~allocation_scope()
+    {
+        detail::thread_allocation_counter() = m_previous;
+    }
+
+    allocation_scope(const allocation_scope&) = delete;
+    allocation_scope& operator=(const allocation_scope&) = delete;
+};
+
+#endif
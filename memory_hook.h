@@ -0,0 +1,47 @@
+#ifndef MEMORY_HOOK_H
+#define MEMORY_HOOK_H
+
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+
+#include <malloc.h>
+
+#include "memory.h"
+
+// The hook of the global allocations.
+// ===================================
+
+/// The replacement of the global operator new and delete reporting the
+/// usable sizes of the blocks to the counter of the current allocation_scope.
+/// To be expanded at the namespace scope of a single translation unit; kept
+/// apart from memory.h, so that only such a program, e.g. the benchmark,
+/// includes the system allocator's header.
+#define TOP_COUNTING_OPERATOR_NEW \
+    void* operator new(std::size_t n) \
+    { \
+        void* p = std::malloc(n ? n : 1); \
+        if (!p) { \
+            throw std::bad_alloc {}; \
+        } \
+        if (allocation_counter* c = detail::thread_allocation_counter()) { \
+            c->allocated(malloc_usable_size(p)); \
+        } \
+        return p; \
+    } \
+    void* operator new[](std::size_t n) { return operator new(n); } \
+    void operator delete(void* p) noexcept \
+    { \
+        if (!p) { \
+            return; \
+        } \
+        if (allocation_counter* c = detail::thread_allocation_counter()) { \
+            c->deallocated(malloc_usable_size(p)); \
+        } \
+        std::free(p); \
+    } \
+    void operator delete[](void* p) noexcept { operator delete(p); } \
+    void operator delete(void* p, std::size_t) noexcept { operator delete(p); } \
+    void operator delete[](void* p, std::size_t) noexcept { operator delete(p); }
+
+#endif
@@ -5,11 +5,13 @@
 
 #include "config.h"
 #include "weight.h"
+#include "memory.h"
 
 #if 0
 
 concept Metric<Weight> : Regular {
     Weight& operator()(edge);
+    static std::size_t version(self);
 };
 
 #endif
@@ -27,6 +29,9 @@ struct hop_metric {
     friend bool operator==(const hop_metric& x, const hop_metric& y) { return true; }
     friend bool operator!=(const hop_metric& x, const hop_metric& y) { return !(x == y); }
 
+    /// The metric never changes.
+    friend std::size_t version(const hop_metric&) { return 0; }
+
     // Metric operations:
     weight_type operator()(const edge&) const
     {
@@ -42,6 +47,7 @@ template <Weight W, bool bidirectional = false>
 class map_metric {
 
     std::map<edge, W> m_impl;
+    std::size_t m_version = 0;
 
 public:
     typedef W weight_type;
@@ -84,6 +90,12 @@ public:
 
     friend bool operator!=(const map_metric& x, const map_metric& y) { return !(x == y); }
 
+    /// The modification counter, bumped by every writable access.
+    friend std::size_t version(const map_metric& x) { return x.m_version; }
+
+    /// The owned memory; the per-edge tree nodes dominate the overhead.
+    friend memory_footprint memory_usage(const map_metric& x) { return detail::map_footprint(x.m_impl); }
+
     // Metric operations:
     const weight_type& operator()(const edge& e) const
     {
@@ -92,8 +104,12 @@ public:
             : m_impl.at(e);
     }
 
+    /// The writable access; any use of it counts as a modification, the
+    /// plain reads included, so that the reads are to go through a const
+    /// reference not to invalidate the derived data, e.g. a spt_cache.
     weight_type& operator()(const edge &e)
     {
+        ++m_version;
         return bidirectional
             ? m_impl[normalize(e)]
             : m_impl[e];
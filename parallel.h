@@ -0,0 +1,70 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+
+#include "thread_pool.h"
+
+namespace detail {
+
+    /// Resolves the requested number of workers; zero means "as many as the
+    /// worker threads of the current pool".
+    inline unsigned worker_count(unsigned requested)
+    {
+        return requested ? requested : thread_pool::current().size();
+    }
+
+    /// Splits the index range [0, count) into contiguous blocks, one per
+    /// worker, and runs f(worker, first, last) for each of them as the tasks
+    /// of the current pool. The worker index identifies the block, so the
+    /// per-worker state indexed by it is never shared. The calling thread
+    /// processes the first block itself.
+    template <typename F>
+    void parallel_blocks(std::size_t count, unsigned workers, F f)
+    {
+        workers = std::max(1u, std::min<unsigned>(workers, std::max<std::size_t>(count, 1)));
+
+        const std::size_t block = count / workers;
+        const std::size_t extra = count % workers;
+        auto block_first = [block, extra](unsigned w) {
+            return w * block + std::min<std::size_t>(w, extra);
+        };
+
+        if (workers == 1) {
+            f(0u, block_first(0), block_first(1));
+            return;
+        }
+
+        thread_pool::task_group group { thread_pool::current() };
+        for (unsigned w = 1; w < workers; ++w) {
+            group.run([&f, &block_first, w]() {
+                f(w, block_first(w), block_first(w + 1));
+            });
+        }
+
+        f(0u, block_first(0), block_first(1));
+
+        group.wait();
+    }
+
+
+    /// Runs f(worker, i) for every index in [0, count) on the given number of
+    /// workers. The indices are handed out one by one, so that
+    /// uneven work items are balanced between the workers.
+    template <typename F>
+    void parallel_for_each_index(std::size_t count, unsigned workers, F f)
+    {
+        std::atomic<std::size_t> next { 0 };
+        parallel_blocks(workers, workers, [&next, count, &f](unsigned w, std::size_t, std::size_t) {
+            std::size_t i;
+            while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+                f(w, i);
+            }
+        });
+    }
+
+}
+
+#endif
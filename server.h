@@ -0,0 +1,783 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <list>
+#include <deque>
+#include <mutex>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <condition_variable>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/socket.h>
+
+#include "algorithms_basic.h"
+#include "algorithms_larac.h"
+#include "algorithms_mlra.h"
+#include "parallel.h"
+
+// The route query server.
+// =======================
+
+/// The protocol of the server. Every message is a frame: the 32 bit length
+/// of the rest of the frame followed by the 32 bit request identifier.
+/// All the integers and doubles are in the host byte order, as the server
+/// is only reachable through a local socket.
+///
+/// The request continues with the 8 bit operation and its arguments:
+/// - dijkstra: u32 src, u32 dst; the cheapest path,
+/// - larac: u32 src, u32 dst, f64 constraint; the cheapest path whose delay
+///   does not exceed the constraint,
+/// - mlra: u32 src, f64 constraint, u32 count, u32 dst[count]; the edges of
+///   the multicast tree,
+/// - stats: no arguments; the latency histograms.
+///
+/// The response continues with the 8 bit status and, if it is ok:
+/// - for dijkstra and larac: f64 cost, f64 delay, u32 count, u32 node[count],
+/// - for mlra: u32 count, (u32 from, u32 to)[count],
+/// - for stats: for every operation but stats the u64 counters of the
+///   latency buckets.
+enum class server_op : std::uint8_t { dijkstra = 0, larac = 1, mlra = 2, stats = 3 };
+
+enum class server_status : std::uint8_t { ok = 0, bad_request = 1, no_path = 2 };
+
+/// The histogram of latencies with the power of two buckets; the bucket i
+/// counts the latencies in [2^(i-1), 2^i) microseconds, the bucket 0 those
+/// below one microsecond. The counters may be updated concurrently.
+class latency_histogram {
+
+public:
+    static const int bucket_count = 32;
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucket_count> m_buckets {};
+
+public:
+    void record(std::chrono::nanoseconds latency)
+    {
+        std::uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+        int i = 0;
+        while (us && i < bucket_count - 1) {
+            us >>= 1;
+            ++i;
+        }
+        m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::uint64_t bucket(int i) const { return m_buckets[i].load(std::memory_order_relaxed); }
+
+    std::uint64_t count() const
+    {
+        std::uint64_t result = 0;
+        for (const auto& b : m_buckets) {
+            result += b.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    /// The upper bound of the given percentile in microseconds; zero if
+    /// nothing has been recorded.
+    std::uint64_t percentile(double p) const
+    {
+        const std::uint64_t total = count();
+        if (!total) {
+            return 0;
+        }
+        std::uint64_t seen = 0;
+        for (int i = 0; i < bucket_count; ++i) {
+            seen += bucket(i);
+            if (seen && seen >= p / 100.0 * total) {
+                return std::uint64_t(1) << i;
+            }
+        }
+        return std::uint64_t(1) << (bucket_count - 1);
+    }
+};
+
+namespace detail {
+
+    template <typename T>
+    void frame_put(std::string& out, const T& x)
+    {
+        out.append(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+
+    /// Reads a value from the buffer; false if the buffer is too short.
+    template <typename T>
+    bool frame_get(const char*& first, const char* last, T& out)
+    {
+        if (last - first < static_cast<std::ptrdiff_t>(sizeof(T))) {
+            return false;
+        }
+        std::memcpy(&out, first, sizeof(T));
+        first += sizeof(T);
+        return true;
+    }
+
+    /// Starts a frame; the length is patched by frame_finish.
+    inline std::string frame_start(std::uint32_t id)
+    {
+        std::string out;
+        frame_put(out, std::uint32_t(0));
+        frame_put(out, id);
+        return out;
+    }
+
+    inline std::string& frame_finish(std::string& frame)
+    {
+        const std::uint32_t length = frame.size() - sizeof(std::uint32_t);
+        std::memcpy(&frame[0], &length, sizeof(length));
+        return frame;
+    }
+
+    inline bool socket_write(int fd, const char* data, std::size_t size)
+    {
+        while (size) {
+            const ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    inline bool socket_read(int fd, char* data, std::size_t size)
+    {
+        while (size) {
+            const ssize_t n = ::recv(fd, data, size, 0);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    /// Reads a whole frame without its length; false at the end of the
+    /// stream or on a frame longer than the limit.
+    inline bool socket_read_frame(int fd, std::string& out, std::uint32_t limit)
+    {
+        std::uint32_t length;
+        if (!socket_read(fd, reinterpret_cast<char*>(&length), sizeof(length)) ||
+                length < sizeof(std::uint32_t) || length > limit) {
+            return false;
+        }
+        out.resize(length);
+        return socket_read(fd, &out[0], length);
+    }
+
+    inline sockaddr_un socket_address(const std::string& path)
+    {
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error("Socket path too long: " + path);
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        return address;
+    }
+
+}
+
+/// The parameters of the server.
+struct server_options {
+    /// The path of the Unix domain socket.
+    std::string socket_path;
+    /// The maximal number of the requests processed together.
+    std::size_t batch_size = 64;
+    /// The maximal number of the queued requests; the connections are not
+    /// read while the queue is full.
+    std::size_t queue_capacity = 1024;
+    /// The maximal length of a request frame.
+    std::uint32_t max_frame = 1 << 20;
+    /// The maximal size of the responses waiting for a connection; a client
+    /// not reading its responses is disconnected past it.
+    std::size_t max_pending = 16 << 20;
+    /// The number of the workers of a batch, zero for the pool size.
+    unsigned threads = 0;
+};
+
+/// The server answering the route queries over a loaded graph.
+///
+/// Every connection has a reader thread decoding the frames into the shared
+/// bounded queue. The dispatcher takes the queued requests in batches and
+/// runs each batch on the current thread_pool, every worker with its own
+/// search workspace. When the queue is full the readers stop reading, so
+/// the clients are pushed back by their socket buffers.
+///
+/// The dispatcher never writes to the sockets: the responses are appended
+/// to the outbox of their connection and sent by its own writer thread, so
+/// that a client not reading its responses stalls nobody else. Such a client
+/// is disconnected once its outbox exceeds the limit.
+///
+/// @tparam Graph A topology,
+/// @tparam Metric A metric of two component weights: the cost and the delay.
+template <class Graph, class Metric>
+class route_server {
+
+public:
+    using weight_type = typename Metric::weight_type;
+
+private:
+    using W = weight_type;
+    using clock = std::chrono::steady_clock;
+
+    struct connection {
+        int fd;
+        std::mutex guard;
+        std::condition_variable ready;
+        /// The responses not sent yet.
+        std::string outbox;
+        /// The requests queued but not answered yet.
+        std::size_t pending = 0;
+        bool reading = true;
+        bool closed = false;
+
+        explicit connection(int fd) : fd { fd } {}
+        ~connection() { ::close(fd); }
+
+        /// Disconnects the client; the guard is to be held.
+        void drop()
+        {
+            closed = true;
+            ::shutdown(fd, SHUT_RDWR);
+            ready.notify_all();
+        }
+    };
+
+    struct request {
+        std::shared_ptr<connection> client;
+        std::string frame;
+        clock::time_point received;
+    };
+
+    const Graph& m_graph;
+    const Metric& m_metric;
+    const server_options m_options;
+    const node m_node_count;
+
+    int m_listener = -1;
+    std::atomic<bool> m_stop { false };
+    std::thread m_acceptor;
+    std::thread m_dispatcher;
+
+    /// The threads serving a connection: the writer, which joins the reader.
+    struct session {
+        std::weak_ptr<connection> client;
+        std::shared_ptr<std::atomic<bool>> done;
+        std::thread thread;
+    };
+
+    std::mutex m_clients_guard;
+    std::list<session> m_sessions;
+
+    std::mutex m_queue_guard;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::deque<request> m_queue;
+
+    std::array<latency_histogram, 3> m_latency;
+
+    bool valid(std::uint32_t n) const
+    {
+        return n < static_cast<std::uint32_t>(m_node_count);
+    }
+
+    void put_path(std::string& out, const path& p) const
+    {
+        W w = weight_traits<W>::zero();
+        std::for_each(edge_begin(p), edge_end(p), [this, &w](const edge& e) { w = w + m_metric(e); });
+        detail::frame_put(out, w[0]);
+        detail::frame_put(out, w[1]);
+        detail::frame_put(out, std::uint32_t(p.size()));
+        for (node n : p) {
+            detail::frame_put(out, std::uint32_t(n));
+        }
+    }
+
+    /// Joins the sessions of the closed connections.
+    void reap()
+    {
+        std::lock_guard<std::mutex> lock { m_clients_guard };
+        for (auto it = begin(m_sessions); it != end(m_sessions);) {
+            if (it->done->load()) {
+                it->thread.join();
+                it = m_sessions.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void accept_loop()
+    {
+        while (!m_stop.load()) {
+            reap();
+            pollfd pfd { m_listener, POLLIN, 0 };
+            if (::poll(&pfd, 1, 50) <= 0) {
+                continue;
+            }
+            const int fd = ::accept(m_listener, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            auto client = std::make_shared<connection>(fd);
+            auto done = std::make_shared<std::atomic<bool>>(false);
+
+            std::lock_guard<std::mutex> lock { m_clients_guard };
+            m_sessions.push_back({ client, done, std::thread { [this, client, done] {
+                std::thread reader { [this, client] {
+                    read_loop(client);
+                    std::lock_guard<std::mutex> lock { client->guard };
+                    client->reading = false;
+                    client->ready.notify_all();
+                } };
+                write_loop(*client);
+                reader.join();
+                done->store(true);
+            } } });
+        }
+    }
+
+    void read_loop(const std::shared_ptr<connection>& client)
+    {
+        std::string frame;
+        while (detail::socket_read_frame(client->fd, frame, m_options.max_frame)) {
+            {
+                std::lock_guard<std::mutex> lock { client->guard };
+                ++client->pending;
+            }
+            std::unique_lock<std::mutex> lock { m_queue_guard };
+            m_not_full.wait(lock, [this] {
+                return m_stop.load() || m_queue.size() < m_options.queue_capacity;
+            });
+            if (m_stop.load()) {
+                return;
+            }
+            m_queue.push_back({ client, std::move(frame), clock::now() });
+            lock.unlock();
+            m_not_empty.notify_one();
+        }
+    }
+
+    /// Sends the responses of the connection until the client is dropped,
+    /// or until it has stopped sending and all its requests are answered.
+    void write_loop(connection& client)
+    {
+        std::string buffer;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock { client.guard };
+                client.ready.wait(lock, [&client] {
+                    return client.closed || !client.outbox.empty() || (!client.reading && !client.pending);
+                });
+                if (client.closed || client.outbox.empty()) {
+                    return;
+                }
+                buffer.clear();
+                buffer.swap(client.outbox);
+            }
+            if (!detail::socket_write(client.fd, buffer.data(), buffer.size())) {
+                std::lock_guard<std::mutex> lock { client.guard };
+                client.drop();
+                return;
+            }
+        }
+    }
+
+    /// Hands the response over to the writer of the connection.
+    void post(connection& client, const std::string& response)
+    {
+        std::lock_guard<std::mutex> lock { client.guard };
+        --client.pending;
+        if (client.closed) {
+            return;
+        }
+        if (client.outbox.size() + response.size() > m_options.max_pending) {
+            client.drop();
+            return;
+        }
+        client.outbox += response;
+        client.ready.notify_all();
+    }
+
+    void dispatch_loop()
+    {
+        const unsigned workers = detail::worker_count(m_options.threads);
+        std::vector<search_workspace<W>> workspaces(workers);
+        std::vector<request> batch;
+        std::vector<std::string> responses;
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock { m_queue_guard };
+                m_not_empty.wait(lock, [this] { return m_stop.load() || !m_queue.empty(); });
+                if (m_stop.load()) {
+                    return;
+                }
+                while (!m_queue.empty() && batch.size() < m_options.batch_size) {
+                    batch.push_back(std::move(m_queue.front()));
+                    m_queue.pop_front();
+                }
+            }
+            m_not_full.notify_all();
+
+            responses.assign(batch.size(), {});
+            detail::parallel_for_each_index(batch.size(), workers, [&](unsigned w, std::size_t i) {
+                auto& ws = workspaces[w];
+                if (ws.preds.empty()) {
+                    ws.resize(m_node_count);
+                }
+                responses[i] = handle(batch[i].frame, ws);
+            });
+
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                post(*batch[i].client, responses[i]);
+                // The frames without an operation have none to account to.
+                const std::string& frame = batch[i].frame;
+                if (frame.size() <= sizeof(std::uint32_t)) {
+                    continue;
+                }
+                const auto op = static_cast<std::uint8_t>(frame[sizeof(std::uint32_t)]);
+                if (op < m_latency.size()) {
+                    m_latency[op].record(clock::now() - batch[i].received);
+                }
+            }
+            batch.clear();
+        }
+    }
+
+public:
+    /// @param g The graph; it must outlive the server and must not change,
+    /// @param m The metric; it must outlive the server and must not change,
+    /// @param options The parameters.
+    route_server(const Graph& g, const Metric& m, server_options options) :
+        m_graph { g },
+        m_metric { m },
+        m_options { std::move(options) },
+        m_node_count { max_node(g) + 1 }
+    {}
+
+    ~route_server()
+    {
+        stop();
+    }
+
+    route_server(const route_server&) = delete;
+    route_server& operator=(const route_server&) = delete;
+
+    /// Binds the socket and starts serving.
+    /// @throws std::runtime_error if the socket cannot be bound.
+    void start()
+    {
+        const sockaddr_un address = detail::socket_address(m_options.socket_path);
+        ::unlink(m_options.socket_path.c_str());
+        m_listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_listener < 0 ||
+                ::bind(m_listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 ||
+                ::listen(m_listener, 64) < 0) {
+            const std::string reason = std::strerror(errno);
+            if (m_listener >= 0) {
+                ::close(m_listener);
+                m_listener = -1;
+            }
+            throw std::runtime_error("Cannot listen on " + m_options.socket_path + ": " + reason);
+        }
+        m_stop.store(false);
+        m_acceptor = std::thread { [this] { accept_loop(); } };
+        m_dispatcher = std::thread { [this] { dispatch_loop(); } };
+    }
+
+    /// Stops serving; the queued requests are dropped.
+    void stop()
+    {
+        if (m_listener < 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock { m_queue_guard };
+            m_stop.store(true);
+        }
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+        m_acceptor.join();
+
+        // The clients are disconnected first, so that no thread waits for
+        // them any more.
+        std::list<session> sessions;
+        {
+            std::lock_guard<std::mutex> lock { m_clients_guard };
+            sessions.swap(m_sessions);
+        }
+        for (auto& s : sessions) {
+            if (auto client = s.client.lock()) {
+                std::lock_guard<std::mutex> lock { client->guard };
+                client->drop();
+            }
+        }
+        m_dispatcher.join();
+        for (auto& s : sessions) {
+            s.thread.join();
+        }
+        m_queue.clear();
+
+        ::close(m_listener);
+        ::unlink(m_options.socket_path.c_str());
+        m_listener = -1;
+    }
+
+    const latency_histogram& latency(server_op op) const
+    {
+        return m_latency[static_cast<std::size_t>(op)];
+    }
+
+    /// Answers a single request frame (without its length); the response
+    /// frame includes its length.
+    std::string handle(const std::string& frame, search_workspace<W>& ws) const
+    {
+        const char* first = frame.data();
+        const char* last = first + frame.size();
+
+        std::uint32_t id = 0;
+        std::uint8_t op = 0;
+        detail::frame_get(first, last, id);
+        std::string out = detail::frame_start(id);
+
+        auto fail = [&out](server_status s) -> std::string& {
+            detail::frame_put(out, static_cast<std::uint8_t>(s));
+            return detail::frame_finish(out);
+        };
+
+        if (!detail::frame_get(first, last, op)) {
+            return fail(server_status::bad_request);
+        }
+
+        std::uint32_t src, dst, count;
+        double constraint;
+
+        switch (static_cast<server_op>(op)) {
+
+        case server_op::dijkstra:
+        case server_op::larac: {
+            if (!detail::frame_get(first, last, src) || !detail::frame_get(first, last, dst) ||
+                    !valid(src) || !valid(dst)) {
+                return fail(server_status::bad_request);
+            }
+            path p;
+            if (op == static_cast<std::uint8_t>(server_op::dijkstra)) {
+                dijkstra(m_graph, m_metric, src, dst, ws, p, weight_cmp_cost<W> {});
+            } else {
+                if (!detail::frame_get(first, last, constraint)) {
+                    return fail(server_status::bad_request);
+                }
+                p = larac(m_graph, m_metric, constraint, src, dst, ws);
+            }
+            if (p.empty()) {
+                return fail(server_status::no_path);
+            }
+            detail::frame_put(out, static_cast<std::uint8_t>(server_status::ok));
+            put_path(out, p);
+            return detail::frame_finish(out);
+        }
+
+        case server_op::mlra: {
+            if (!detail::frame_get(first, last, src) || !detail::frame_get(first, last, constraint) ||
+                    !detail::frame_get(first, last, count) || !valid(src) ||
+                    static_cast<std::size_t>(last - first) != count * sizeof(std::uint32_t)) {
+                return fail(server_status::bad_request);
+            }
+            std::vector<node> dsts(count);
+            for (node& d : dsts) {
+                detail::frame_get(first, last, dst);
+                if (!valid(dst)) {
+                    return fail(server_status::bad_request);
+                }
+                d = dst;
+            }
+            // The batch already occupies the workers.
+            const tree t = mlra(m_graph, m_metric, constraint, src, begin(dsts), end(dsts), 1);
+            if (edge_begin(t) == edge_end(t) && count) {
+                return fail(server_status::no_path);
+            }
+            detail::frame_put(out, static_cast<std::uint8_t>(server_status::ok));
+            detail::frame_put(out, std::uint32_t(std::distance(edge_begin(t), edge_end(t))));
+            std::for_each(edge_begin(t), edge_end(t), [&out](const edge& e) {
+                detail::frame_put(out, std::uint32_t(e.first));
+                detail::frame_put(out, std::uint32_t(e.second));
+            });
+            return detail::frame_finish(out);
+        }
+
+        case server_op::stats: {
+            detail::frame_put(out, static_cast<std::uint8_t>(server_status::ok));
+            for (const auto& h : m_latency) {
+                for (int i = 0; i < latency_histogram::bucket_count; ++i) {
+                    detail::frame_put(out, h.bucket(i));
+                }
+            }
+            return detail::frame_finish(out);
+        }
+
+        }
+
+        return fail(server_status::bad_request);
+    }
+};
+
+/// A blocking client of the route_server.
+class route_client {
+
+    int m_fd;
+    std::uint32_t m_next_id = 0;
+
+public:
+    /// A decoded response.
+    struct reply {
+        server_status status;
+        double cost = 0.0;
+        double delay = 0.0;
+        path p;
+        std::vector<edge> edges;
+        std::vector<std::uint64_t> buckets;
+    };
+
+    /// @throws std::runtime_error if the server is not reachable.
+    explicit route_client(const std::string& socket_path)
+    {
+        const sockaddr_un address = detail::socket_address(socket_path);
+        m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_fd < 0 || ::connect(m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+            const std::string reason = std::strerror(errno);
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+            throw std::runtime_error("Cannot connect to " + socket_path + ": " + reason);
+        }
+    }
+
+    ~route_client() { ::close(m_fd); }
+
+    route_client(const route_client&) = delete;
+    route_client& operator=(const route_client&) = delete;
+
+    /// Sends a request frame without waiting for the response.
+    /// @return The identifier of the request.
+    std::uint32_t send(server_op op, const std::string& arguments)
+    {
+        const std::uint32_t id = m_next_id++;
+        std::string frame = detail::frame_start(id);
+        detail::frame_put(frame, static_cast<std::uint8_t>(op));
+        frame += arguments;
+        detail::frame_finish(frame);
+        if (!detail::socket_write(m_fd, frame.data(), frame.size())) {
+            throw std::runtime_error("Cannot send the request.");
+        }
+        return id;
+    }
+
+    /// Receives the next response; the responses of a connection arrive in
+    /// the order of the requests.
+    std::pair<std::uint32_t, reply> receive(server_op op)
+    {
+        std::string frame;
+        if (!detail::socket_read_frame(m_fd, frame, std::numeric_limits<std::uint32_t>::max())) {
+            throw std::runtime_error("Cannot receive the response.");
+        }
+        const char* first = frame.data();
+        const char* last = first + frame.size();
+        std::uint32_t id, count, u, v;
+        std::uint8_t status;
+        detail::frame_get(first, last, id);
+        detail::frame_get(first, last, status);
+
+        reply r;
+        r.status = static_cast<server_status>(status);
+        if (r.status != server_status::ok) {
+            return { id, r };
+        }
+        switch (op) {
+        case server_op::dijkstra:
+        case server_op::larac:
+            detail::frame_get(first, last, r.cost);
+            detail::frame_get(first, last, r.delay);
+            detail::frame_get(first, last, count);
+            for (std::uint32_t i = 0; i < count && detail::frame_get(first, last, u); ++i) {
+                r.p.push_back(u);
+            }
+            break;
+        case server_op::mlra:
+            detail::frame_get(first, last, count);
+            for (std::uint32_t i = 0; i < count && detail::frame_get(first, last, u) &&
+                    detail::frame_get(first, last, v); ++i) {
+                r.edges.emplace_back(u, v);
+            }
+            break;
+        case server_op::stats:
+            for (std::uint64_t x; detail::frame_get(first, last, x);) {
+                r.buckets.push_back(x);
+            }
+            break;
+        }
+        return { id, r };
+    }
+
+    reply dijkstra(node src, node dst)
+    {
+        std::string args;
+        detail::frame_put(args, std::uint32_t(src));
+        detail::frame_put(args, std::uint32_t(dst));
+        send(server_op::dijkstra, args);
+        return receive(server_op::dijkstra).second;
+    }
+
+    reply larac(node src, node dst, double constraint)
+    {
+        std::string args;
+        detail::frame_put(args, std::uint32_t(src));
+        detail::frame_put(args, std::uint32_t(dst));
+        detail::frame_put(args, constraint);
+        send(server_op::larac, args);
+        return receive(server_op::larac).second;
+    }
+
+    reply mlra(node src, double constraint, const std::vector<node>& dsts)
+    {
+        std::string args;
+        detail::frame_put(args, std::uint32_t(src));
+        detail::frame_put(args, constraint);
+        detail::frame_put(args, std::uint32_t(dsts.size()));
+        for (node d : dsts) {
+            detail::frame_put(args, std::uint32_t(d));
+        }
+        send(server_op::mlra, args);
+        return receive(server_op::mlra).second;
+    }
+
+    reply stats()
+    {
+        send(server_op::stats, {});
+        return receive(server_op::stats).second;
+    }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <csignal>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+
+#include "weight.h"
+#include "metric.h"
+#include "topology.h"
+#include "graph_io.h"
+#include "server.h"
+#include "connectivity_index.h"
+
+/// The route query server: loads the graph once and serves the queries
+/// until SIGINT or SIGTERM.
+///
+/// Usage: top_server <graph file> <socket path> [threads] [batch size]
+int main(int argc, char* argv[])
+{
+    using W = array_weight<double, 2>;
+
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <graph file> <socket path> [threads] [batch size]" << std::endl;
+        return 1;
+    }
+
+    // The signals are taken synchronously by the main thread; all the
+    // threads started later inherit the mask.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // The index rejects the queries between the disconnected nodes at once.
+    indexed_graph<adj_list> g;
+    map_metric<W, true> m;
+    try {
+        std::ifstream in { argv[1] };
+        if (!in) {
+            throw std::runtime_error(std::string("Cannot open ") + argv[1] + ".");
+        }
+        load_graph(in, g, m);
+
+        server_options options;
+        options.socket_path = argv[2];
+        if (argc > 3) {
+            options.threads = std::stoul(argv[3]);
+        }
+        if (argc > 4) {
+            options.batch_size = std::stoul(argv[4]);
+        }
+
+        if (options.threads) {
+            static thread_pool pool { options.threads };
+            thread_pool::set_default(&pool);
+        }
+
+        route_server<indexed_graph<adj_list>, map_metric<W, true>> server { g, m, options };
+        server.start();
+        std::cerr << "Serving " << argv[1] << " on " << options.socket_path << std::endl;
+
+        int signal;
+        sigwait(&signals, &signal);
+
+        server.stop();
+        for (auto op : { server_op::dijkstra, server_op::larac, server_op::mlra }) {
+            const latency_histogram& h = server.latency(op);
+            std::cerr << "op " << int(op) << ": " << h.count() << " requests, p50 < "
+                      << h.percentile(50) << " us, p99 < " << h.percentile(99) << " us" << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,208 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <mutex>
+#include <limits>
+#include <atomic>
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+
+#include "config.h"
+
+/// The publisher of the immutable versions of a topology and a metric.
+///
+/// The readers pin the current snapshot without locking: a pin announces
+/// the global epoch in the reader's slot and then loads the current snapshot
+/// pointer. The writer prepares the next version off the hot path and
+/// publishes it with an atomic pointer swap; the replaced snapshot is retired
+/// with the epoch of the swap and destroyed once no reader is pinned in that
+/// epoch or an earlier one (epoch based reclamation).
+///
+/// The readers must be registered, up to the number of slots given at the
+/// construction; each registered reader may be used by one thread at a time
+/// and may hold one pin at a time. There is a single writer at a time.
+///
+/// @tparam Topology A topology,
+/// @tparam Metric A metric.
+template <class Topology, class Metric>
+class snapshot_manager {
+
+public:
+    /// An immutable version of the topology and the metric.
+    struct snapshot {
+        Topology topology;
+        Metric metric;
+        std::size_t version = 0;
+    };
+
+private:
+    static const std::uint64_t idle = 0;
+
+    /// The slots are padded so that the readers do not share cache lines.
+    struct slot {
+        std::atomic<std::uint64_t> epoch { idle };
+        std::atomic<bool> taken { false };
+        char padding[64 - sizeof(std::atomic<std::uint64_t>) - sizeof(std::atomic<bool>)];
+    };
+
+    std::atomic<const snapshot*> m_current;
+    std::atomic<std::uint64_t> m_epoch { 1 };
+    std::unique_ptr<slot[]> m_slots;
+    const std::size_t m_slot_count;
+
+    std::mutex m_writer;
+    std::vector<std::pair<std::uint64_t, std::unique_ptr<const snapshot>>> m_retired;
+
+    /// Destroys the retired snapshots no reader may still see.
+    /// Must be called with the writer lock held.
+    void reclaim()
+    {
+        std::uint64_t oldest = std::numeric_limits<std::uint64_t>::max();
+        for (std::size_t i = 0; i < m_slot_count; ++i) {
+            const std::uint64_t e = m_slots[i].epoch.load();
+            if (e != idle) {
+                oldest = std::min(oldest, e);
+            }
+        }
+        auto last = std::remove_if(begin(m_retired), end(m_retired),
+            [oldest](const std::pair<std::uint64_t, std::unique_ptr<const snapshot>>& r) {
+                return r.first < oldest;
+            });
+        m_retired.erase(last, end(m_retired));
+    }
+
+public:
+    class reader;
+
+    /// The pinned snapshot; the snapshot stays alive while the pin exists.
+    class pin {
+
+        friend class reader;
+
+        slot* m_slot;
+        const snapshot* m_snapshot;
+
+        pin(slot* s, const snapshot* x) : m_slot { s }, m_snapshot { x } {}
+
+    public:
+        pin(const pin&) = delete;
+        pin& operator=(const pin&) = delete;
+        pin(pin&& x) : m_slot { x.m_slot }, m_snapshot { x.m_snapshot } { x.m_slot = nullptr; }
+
+        ~pin()
+        {
+            if (m_slot) {
+                m_slot->epoch.store(idle);
+            }
+        }
+
+        const snapshot& operator*() const { return *m_snapshot; }
+        const snapshot* operator->() const { return m_snapshot; }
+        const Topology& topology() const { return m_snapshot->topology; }
+        const Metric& metric() const { return m_snapshot->metric; }
+    };
+
+    /// The registration of a reader, i.e. the ownership of a slot.
+    class reader {
+
+        friend class snapshot_manager;
+
+        snapshot_manager* m_manager;
+        slot* m_slot;
+
+        reader(snapshot_manager* m, slot* s) : m_manager { m }, m_slot { s } {}
+
+    public:
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+        reader(reader&& x) : m_manager { x.m_manager }, m_slot { x.m_slot } { x.m_slot = nullptr; }
+
+        ~reader()
+        {
+            if (m_slot) {
+                m_slot->taken.store(false);
+            }
+        }
+
+        pin acquire() const
+        {
+            assert(m_slot->epoch.load() == idle);
+            m_slot->epoch.store(m_manager->m_epoch.load());
+            return { m_slot, m_manager->m_current.load() };
+        }
+    };
+
+    /// @param initial The initial version,
+    /// @param max_readers The number of the reader slots.
+    explicit snapshot_manager(snapshot initial, std::size_t max_readers = 64) :
+        m_current { new snapshot(std::move(initial)) },
+        m_slots { new slot[max_readers] },
+        m_slot_count { max_readers }
+    {}
+
+    snapshot_manager(Topology t, Metric m, std::size_t max_readers = 64) :
+        snapshot_manager { snapshot { std::move(t), std::move(m), 0 }, max_readers }
+    {}
+
+    ~snapshot_manager()
+    {
+        delete m_current.load();
+    }
+
+    snapshot_manager(const snapshot_manager&) = delete;
+    snapshot_manager& operator=(const snapshot_manager&) = delete;
+
+    reader register_reader()
+    {
+        for (std::size_t i = 0; i < m_slot_count; ++i) {
+            bool expected = false;
+            if (m_slots[i].taken.compare_exchange_strong(expected, true)) {
+                return { this, &m_slots[i] };
+            }
+        }
+        throw std::runtime_error("No free reader slot.");
+    }
+
+    /// A private copy of the current version for the writer to modify.
+    snapshot prepare()
+    {
+        std::lock_guard<std::mutex> lock { m_writer };
+        return *m_current.load();
+    }
+
+    /// Publishes the next version; the replaced one is retired.
+    /// @return The number of the published version.
+    std::size_t publish(snapshot next)
+    {
+        std::lock_guard<std::mutex> lock { m_writer };
+        next.version = m_current.load()->version + 1;
+        const std::size_t result = next.version;
+        const snapshot* old = m_current.exchange(new snapshot(std::move(next)));
+        m_retired.emplace_back(m_epoch.fetch_add(1), std::unique_ptr<const snapshot>(old));
+        reclaim();
+        return result;
+    }
+
+    /// Destroys the retired snapshots that are no longer pinned.
+    void collect()
+    {
+        std::lock_guard<std::mutex> lock { m_writer };
+        reclaim();
+    }
+
+    std::size_t retired_count()
+    {
+        std::lock_guard<std::mutex> lock { m_writer };
+        return m_retired.size();
+    }
+};
+
+template <class Topology, class Metric>
+const std::uint64_t snapshot_manager<Topology, Metric>::idle;
+
+#endif
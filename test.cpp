@@ -8,5 +8,6 @@ void test()
     test_metric();
     test_topology();
     test_algorithm();
+    test_server();
 }
 
@@ -1,3 +1,6 @@
+#include <atomic>
+#include <stdexcept>
+
 #include "test_common.h"
 #include "metric.h"
 #include "weight_util.h"
@@ -7,6 +10,17 @@
 #include "algorithms_larac.h"
 #include "algorithms_mlra.h"
 #include "algorithms_lbpsa.h"
+#include "algorithms_parallel.h"
+#include "algorithms_pareto.h"
+#include "algorithms_yen.h"
+#include "algorithms_dynamic.h"
+#include "algorithms_cache.h"
+#include "algorithms_steiner.h"
+#include "algorithms_failure.h"
+#include "connectivity_index.h"
+#include "thread_pool.h"
+#include "tree_index.h"
+#include "generators.h"
 
 namespace {
 
@@ -115,6 +129,86 @@ namespace {
         f(edge { 7, 4 }, array_weight<double, 2> { 199.0, 561.0 });
     }
 
+    /// Exhaustive search of the cheapest simple path fulfilling the
+    /// constraints; the reference for the multi-constrained algorithms.
+    template <class Graph, class Metric>
+    double brute_force_constrained_cost(
+            const Graph& g, const Metric& m, const std::vector<double>& cstr,
+            path& current, node dst, const typename Metric::weight_type& w)
+    {
+        node u = current.back();
+        if (u == dst) {
+            for (std::size_t i = 0; i < cstr.size(); ++i) {
+                if (w[i + 1] > cstr[i]) {
+                    return std::numeric_limits<double>::infinity();
+                }
+            }
+            return w[0];
+        }
+
+        double result = std::numeric_limits<double>::infinity();
+        std::for_each(out_begin(g, u), out_end(g, u), [&](node v) {
+            if (std::find(begin(current), end(current), v) != end(current)) {
+                return;
+            }
+            current.push_back(v);
+            result = std::min(result, brute_force_constrained_cost(g, m, cstr, current, dst, w + m(edge(u, v))));
+            current.pop_back();
+        });
+        return result;
+    }
+
+    /// Exhaustive enumeration of the weights of all the simple paths.
+    template <class Graph, class Metric>
+    void brute_force_path_weights(
+            const Graph& g, const Metric& m, path& current, node dst,
+            const typename Metric::weight_type& w,
+            std::vector<typename Metric::weight_type>& out)
+    {
+        node u = current.back();
+        if (u == dst) {
+            out.push_back(w);
+            return;
+        }
+        std::for_each(out_begin(g, u), out_end(g, u), [&](node v) {
+            if (std::find(begin(current), end(current), v) == end(current)) {
+                current.push_back(v);
+                brute_force_path_weights(g, m, current, dst, w + m(edge(u, v)), out);
+                current.pop_back();
+            }
+        });
+    }
+
+    template <class Graph, class Metric>
+    void fill_random_grid(Graph& g, Metric& m, int width, int height, unsigned seed)
+    {
+        using W = typename Metric::weight_type;
+
+        auto next = [&seed]() {
+            seed = seed * 1103515245u + 12345u;
+            return static_cast<double>((seed >> 16) % 100 + 1);
+        };
+
+        auto connect = [&](node u, node v) {
+            W w;
+            for (auto& x : w) {
+                x = next();
+            }
+            g.set(edge { u, v });
+            g.set(edge { v, u });
+            m(edge { u, v }) = w;
+            m(edge { v, u }) = w;
+        };
+
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                node u = y * width + x;
+                if (x + 1 < width) connect(u, u + 1);
+                if (y + 1 < height) connect(u, u + width);
+            }
+        }
+    }
+
     template <class Graph>
     void prepare_wiki_graph(Graph& g)
     {
@@ -142,6 +236,415 @@ namespace {
         }};
 
         assert(t == expected_tree);
+
+        std::vector<node> all_dst { 0, 1, 2, 4, 5, 6, 7, 8 };
+        tree sequential = mlra(g, m, 10000, src, begin(all_dst), end(all_dst), 1);
+        for (unsigned threads : { 2u, 3u, 8u }) {
+            assert(mlra(g, m, 10000, src, begin(all_dst), end(all_dst), threads) == sequential);
+        }
+
+        // Destinations requiring the Lagrangian refinement must yield the union
+        // of the independent LARAC paths.
+        adj_matrix mg;
+        map_metric<W, true> mm;
+        for_each_mpiech_weight([&mg, &mm](const edge& e, const W& w) {
+            mg.set(e); mg.set(reverse(e));
+            mm(e) = w;
+        });
+
+        std::vector<node> mdst { 1, 2, 3, 7 };
+        tree expected_union;
+        for (node d : mdst) {
+            path p = larac(mg, mm, 1000.0, 0, d);
+            assert(!p.empty());
+            std::for_each(edge_begin(p), edge_end(p), [&expected_union](const edge& e) {
+                expected_union.set(e);
+                expected_union.set(reverse(e));
+            });
+        }
+        tree mt = mlra(mg, mm, 1000.0, 0, begin(mdst), end(mdst));
+        assert(mt == shortest_path_tree(expected_union, mm, 0, weight_cmp_cost<W> {}));
+    }
+
+    void test_larac_tree()
+    {
+        using W = array_weight<double, 2>;
+
+        // The mpiech scenario of test_mlra.
+        adj_matrix mg;
+        map_metric<W, true> mm;
+        for_each_mpiech_weight([&mg, &mm](const edge& e, const W& w) {
+            mg.set(e); mg.set(reverse(e));
+            mm(e) = w;
+        });
+        std::vector<node> mdst { 1, 2, 3, 7 };
+        assert(larac_tree(mg, mm, 1000.0, 0, begin(mdst), end(mdst)) == mlra(mg, mm, 1000.0, 0, begin(mdst), end(mdst)));
+
+        // A generated grid with many destinations: every destination gets
+        // a path as good as that of its own LARAC, with fewer searches.
+        csr_graph g;
+        csr_metric<W> m;
+        generate_grid(20, 20, 7, g, m);
+        std::vector<node> dsts;
+        for (node d = 1; d < 400; d += 3) {
+            dsts.push_back(d);
+        }
+        const double constraint = 600.0;
+
+        counting_stats shared;
+        const std::vector<path> paths = larac_paths(g, m, constraint, 0, begin(dsts), end(dsts), 0, shared);
+        assert(paths.size() == dsts.size());
+
+        counting_stats single;
+        search_workspace<W> ws { nodes_count(g) };
+        std::size_t feasible = 0;
+        for (std::size_t i = 0; i < dsts.size(); ++i) {
+            const path expected = larac(g, m, constraint, 0, dsts[i], ws, single);
+            assert(paths[i].empty() == expected.empty());
+            if (!expected.empty()) {
+                ++feasible;
+                const W w = accumulate_weight(m, paths[i]);
+                assert(w[1] <= constraint);
+                assert(w[0] == accumulate_weight(m, expected)[0]);
+            }
+        }
+        assert(feasible > 0);
+        assert(shared.counters.nodes_settled < single.counters.nodes_settled);
+
+        // A destination without a feasible path empties the tree.
+        assert(larac_tree(g, m, 1.0, 0, begin(dsts), end(dsts)).m_impl.empty());
+    }
+
+    void test_tree_index()
+    {
+        using W = array_weight<double, 2>;
+
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+
+        // The paths of the tree are the only paths of its symmetric copy.
+        const tree t = prim(g, m, 3);
+        adj_list tg;
+        std::for_each(edge_begin(t), edge_end(t), [&tg](const edge& e) { tg.set(e); tg.set(reverse(e)); });
+
+        const tree_index<double> index { t, m };
+        assert(index.root(0) == 3 && index.lca(0, 3) == 3);
+        for (node u = 0; u < 6; ++u) {
+            for (node v = 0; v < 6; ++v) {
+                const path expected = dijkstra(tg, m, u, v);
+                assert(index.route(u, v) == expected);
+                assert(index.distance(u, v) == accumulate_weight(m, expected));
+                const node a = index.lca(u, v);
+                assert(a == index.lca(v, u));
+                assert(std::find(begin(expected), end(expected), a) != end(expected));
+                assert(index.depth(a) <= std::min(index.depth(u), index.depth(v)));
+            }
+        }
+
+        // The trees of a forest are not connected to each other.
+        tree forest;
+        forest.set({ 0, 1 });
+        forest.set({ 1, 2 });
+        forest.set({ 5, 4 });
+        const tree_index<double> findex { forest, hop_metric<double> {} };
+        assert(findex.distance(0, 2) == 2.0);
+        assert(findex.lca(2, 4) == -1 && findex.route(2, 4).empty());
+        assert(findex.distance(2, 4) == weight_traits<double>::inf());
+        assert(!findex.contains(3) && !findex.contains(7));
+        assert(memory_usage(findex).payload > 0);
+
+        // The multi-weights of a multicast tree between its receivers.
+        adj_matrix mg;
+        map_metric<W, true> mm;
+        for_each_mpiech_weight([&mg, &mm](const edge& e, const W& w) {
+            mg.set(e); mg.set(reverse(e));
+            mm(e) = w;
+        });
+        std::vector<node> mdst { 1, 2, 3, 7 };
+        const tree mt = mlra(mg, mm, 1000.0, 0, begin(mdst), end(mdst));
+        const tree_index<W> mindex { mt, mm };
+        for (node u : mdst) {
+            for (node v : mdst) {
+                assert(mindex.distance(u, v) == accumulate_weight(mm, mindex.route(u, v)));
+            }
+        }
+    }
+
+    void test_steiner()
+    {
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+
+        // The regions of 1, 3 and 5 are joined through the node 2.
+        std::vector<node> terminals { 1, 3, 5 };
+        const tree expected {{ { 1, 2 }, { 2, 3 }, { 2, 5 } }};
+        const tree st = steiner_tree(g, m, begin(terminals), end(terminals));
+        assert(st == expected);
+        assert(accumulate_weight(m, st) == 23.0);
+
+        // Two terminals are joined by their shortest path.
+        std::vector<node> pair { 0, 4, 0 };
+        const tree sp = steiner_tree(g, m, begin(pair), end(pair));
+        assert(accumulate_weight(m, sp) == accumulate_weight(m, dijkstra(g, m, 0, 4)));
+
+        // A grid with the terminals in its corners: all the leaves are
+        // terminals and the tree is at most as expensive as the union of
+        // the shortest paths.
+        using W = array_weight<double, 2>;
+        adj_list grid;
+        map_metric<W, true> gm;
+        fill_grid(grid, gm, 6, 6, W { 1.0, 1.0 }, W { 3.0, 1.0 }, { { 0, 1 }, { 1, 7 }, { 7, 13 }, { 13, 14 } });
+        std::vector<node> corners { 0, 5, 30, 35, 14 };
+        const tree gt = steiner_tree(grid, gm, begin(corners), end(corners), weight_cmp_cost<W> {});
+        tree spt_union;
+        for (node d : corners) {
+            const path p = dijkstra(grid, gm, 0, d, weight_cmp_cost<W> {});
+            std::for_each(edge_begin(p), edge_end(p), [&spt_union](const edge& e) { spt_union.set(normalize(e)); });
+        }
+        std::map<node, int> degree;
+        std::for_each(edge_begin(gt), edge_end(gt), [&degree](const edge& e) { ++degree[e.first]; ++degree[e.second]; });
+        for (const auto& pr : degree) {
+            assert(pr.second > 1 || std::find(begin(corners), end(corners), pr.first) != end(corners));
+        }
+        for (node c : corners) {
+            assert(degree.count(c));
+        }
+        assert(static_cast<std::ptrdiff_t>(degree.size()) == std::distance(edge_begin(gt), edge_end(gt)) + 1);
+        assert(accumulate_cost(gm, gt) <= accumulate_cost(gm, spt_union));
+
+        // Disconnected terminals.
+        g.set({ 7, 8 });
+        g.set({ 8, 7 });
+        m({ 7, 8 }) = 1.0;
+        std::vector<node> apart { 0, 8 };
+        assert(steiner_tree(g, m, begin(apart), end(apart)) == tree {});
+    }
+
+    void test_failure_impact()
+    {
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+
+        // Every entry agrees with a search of the topology without the link.
+        std::vector<node> sources { 0, 3 };
+        const std::vector<demand> demands = source_demands(g, begin(sources), end(sources));
+        const failure_table<double> table = link_failure_impact(g, m, demands);
+        assert(table.demands.size() == 10 && table.failures.size() == 9);
+        assert(table.searches > 0 && table.searches < table.failures.size() * sources.size());
+
+        search_workspace<double> ws { 6 };
+        std::size_t affected = 0;
+        for (std::size_t f = 0; f < table.failures.size(); ++f) {
+            const edge e = table.failures[f].front();
+            const topology_view<adj_list> view { g, nullptr, { e, reverse(e) } };
+            for (std::size_t d = 0; d < demands.size(); ++d) {
+                const node src = demands[d].first, dst = demands[d].second;
+                detail::dijkstra_relax(view, m, src, ws, detail::never_stop {}, std::less<double> {});
+                assert(table.cost(f, d) == ws.dists[dst]);
+                const path p = table.route(f, d);
+                assert(p.front() == src && p.back() == dst);
+                assert(accumulate_weight(m, p) == ws.dists[dst]);
+                assert(std::find(edge_begin(p), edge_end(p), e) == edge_end(p));
+                assert(std::find(edge_begin(p), edge_end(p), reverse(e)) == edge_end(p));
+                if (table.affected(f, d)) {
+                    ++affected;
+                } else {
+                    assert(table.cost(f, d) == table.baseline[d]);
+                }
+            }
+        }
+        assert(affected > 0);
+
+        // A shared risk group cutting off a node, with a single worker.
+        std::vector<std::vector<edge>> groups { { { 4, 3 }, { 5, 4 } }, { { 0, 1 } } };
+        const failure_table<double> cut = failure_impact(g, m, demands, groups, std::less<double> {}, 1);
+        const std::size_t to_4 = std::find(begin(demands), end(demands), demand { 0, 4 }) - begin(demands);
+        assert(cut.cost(0, to_4) == weight_traits<double>::inf() && cut.route(0, to_4).empty());
+        assert(cut.cost(1, to_4) == table.baseline[to_4] && !cut.affected(1, to_4));
+        assert((cut.route(1, 0) == path { 0, 2, 1 }) && cut.cost(1, 0) == 19.0);
+
+        // The table does not depend on the number of workers.
+        using W = array_weight<double, 2>;
+        csr_graph grid;
+        csr_metric<W> gm;
+        generate_grid(8, 8, 11, grid, gm);
+        const std::vector<demand> grid_demands = source_demands(grid, begin(sources), end(sources));
+        const auto serial = link_failure_impact(grid, gm, grid_demands, weight_cmp_cost<W> {}, 1);
+        const auto parallel = link_failure_impact(grid, gm, grid_demands, weight_cmp_cost<W> {}, 4);
+        assert(serial.rows == parallel.rows && serial.offsets == parallel.offsets && serial.hops == parallel.hops);
+        for (std::size_t k = 0; k < serial.changes.size(); ++k) {
+            assert(serial.changes[k].index == parallel.changes[k].index);
+            assert(serial.changes[k].cost == parallel.changes[k].cost);
+        }
+        assert(serial.changes.size() < serial.failures.size() * grid_demands.size() / 4);
+    }
+
+    void test_connectivity()
+    {
+        using W = array_weight<double, 2>;
+
+        // The unreachable destinations give the empty paths.
+        adj_list g;
+        prepare_wiki_graph(g);
+        g.set({ 7, 8 });
+        g.set({ 8, 7 });
+        map_metric<W, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = W { val, 20.0 - val }; });
+        m({ 7, 8 }) = W { 1.0, 1.0 };
+        assert(dijkstra(g, m, 0, 8, weight_cmp_cost<W> {}).empty());
+        assert(bellman_ford(g, m, 0, 7, weight_cmp_cost<W> {}).empty());
+        assert(larac(g, m, 100.0, 0, 8).empty());
+
+        // The strong components are numbered sinks first: the cycle
+        // 0 -> 1 -> 2 -> 0 reaches the cycle 3 <-> 4, but not the other
+        // way round; 5 and 6 are apart.
+        adj_list d;
+        for (const edge& e : std::vector<edge> { { 0, 1 }, { 1, 2 }, { 2, 0 }, { 2, 3 }, { 3, 4 }, { 4, 3 }, { 6, 5 } }) {
+            d.set(e);
+        }
+        connectivity_index ci { d };
+        assert(ci.strong_valid());
+        assert(ci.strongly_connected(0, 2) && ci.strongly_connected(3, 4) && !ci.strongly_connected(2, 3));
+        assert(ci.weakly_connected(0, 4) && !ci.weakly_connected(0, 5) && ci.weakly_connected(5, 6));
+        assert(!ci.unreachable(0, 4) && ci.unreachable(4, 0));
+        assert(!ci.unreachable(6, 5) && ci.unreachable(5, 6) && ci.unreachable(0, 6));
+        assert(ci.unreachable(0, 100) && !ci.unreachable(100, 100));
+
+        // An edge along the numbering keeps it, one against it does not.
+        ci.add({ 1, 3 });
+        assert(ci.strong_valid() && ci.unreachable(4, 1));
+        ci.add({ 4, 0 });
+        assert(!ci.strong_valid() && !ci.unreachable(4, 1));
+        ci.add({ 9, 6 });
+        assert(ci.weakly_connected(9, 5) && ci.unreachable(0, 9));
+
+        // The indexed graph answers without any search.
+        indexed_graph<adj_list> ig { g };
+        counting_stats stats;
+        search_workspace<W> ws { max_node(ig) + 1 };
+        path p;
+        assert(dijkstra(ig, m, 0, 8, ws, p, weight_cmp_cost<W> {}, stats) == weight_traits<W>::inf() && p.empty());
+        assert(larac(ig, m, 100.0, 0, 7, ws, stats).empty());
+        assert(stats.counters == search_counters {});
+        std::vector<node> dsts { 4, 8 };
+        assert(mlra(ig, m, 100.0, 0, begin(dsts), end(dsts)) == tree {});
+        assert(larac_tree(ig, m, 100.0, 0, begin(dsts), end(dsts)) == tree {});
+        const std::vector<node> far { 7, 8 };
+        assert(larac_paths(ig, m, 100.0, 0, begin(far), end(far), 0, stats) == std::vector<path>(2));
+        assert(stats.counters == search_counters {});
+        assert(dijkstra(ig, m, 0, 4, ws, p, weight_cmp_cost<W> {}, stats) == dijkstra(g, m, 0, 4, ws, p, weight_cmp_cost<W> {}));
+        assert(stats.counters.nodes_settled > 0);
+        assert(known_unreachable(topology_view<indexed_graph<adj_list>> { ig }, 7, 0));
+
+        // The set() of the edges keeps the index up to date.
+        ig.set({ 5, 7 });
+        ig.set({ 7, 5 });
+        m({ 5, 7 }) = W { 1.0, 1.0 };
+        assert(!known_unreachable(ig, 0, 8));
+        assert((dijkstra(ig, m, 0, 8, weight_cmp_cost<W> {}) == path { 0, 2, 5, 7, 8 }));
+        ig.refresh();
+        assert(ig.index().strong_valid() && ig.index().strongly_connected(0, 8));
+        assert(memory_usage(ig).total() > memory_usage(ig.graph()).total());
+
+        // The graph loaded edge by edge along the edges keeps the numbering.
+        indexed_graph<adj_list> loaded;
+        loaded.set({ 0, 1 });
+        loaded.set({ 1, 2 });
+        loaded.set({ 0, 3 });
+        assert(loaded.index().strong_valid());
+        assert(known_unreachable(loaded, 2, 0) && known_unreachable(loaded, 3, 1));
+        assert(!known_unreachable(loaded, 0, 2));
+        loaded.set({ 2, 0 });
+        assert(!loaded.index().strong_valid() && !known_unreachable(loaded, 2, 0));
+
+        // The deep topologies are traversed without the recursion.
+        const node chain = 200000;
+        std::vector<edge> edges;
+        for (node u = 0; u + 1 < chain; ++u) {
+            edges.emplace_back(u, u + 1);
+        }
+        const connectivity_index deep { adj_list { begin(edges), end(edges) } };
+        assert(deep.unreachable(chain - 1, 0) && !deep.unreachable(0, chain - 1));
+    }
+
+    void test_lbpsa()
+    {
+        using W = array_weight<double, 3>;
+
+        adj_list g;
+        map_metric<W> m;
+        fill_random_grid(g, m, 4, 3, 7u);
+
+        const node src = 0, dst = 11;
+        for (const auto& cstr : std::vector<std::vector<double>> {
+                { 1000.0, 1000.0 }, { 250.0, 300.0 }, { 200.0, 150.0 }, { 120.0, 400.0 }, { 10.0, 10.0 } }) {
+
+            path current { src };
+            const double expected = brute_force_constrained_cost(g, m, cstr, current, dst, weight_traits<W>::zero());
+
+            for (unsigned threads : { 1u, 4u }) {
+                path p = lbpsa(g, m, cstr, src, dst, threads);
+                if (expected == std::numeric_limits<double>::infinity()) {
+                    assert(p.empty());
+                    continue;
+                }
+                assert(!p.empty() && p.front() == src && p.back() == dst);
+                W w = accumulate_weight(m, p);
+                assert(w[0] == expected);
+                assert(w[1] <= cstr[0] && w[2] <= cstr[1]);
+            }
+        }
+    }
+
+    void test_pareto()
+    {
+        using W = array_weight<double, 3>;
+
+        adj_list g;
+        map_metric<W> m;
+        fill_random_grid(g, m, 4, 3, 11u);
+
+        const node src = 0, dst = 11;
+
+        std::vector<W> all;
+        path current { src };
+        brute_force_path_weights(g, m, current, dst, weight_traits<W>::zero(), all);
+
+        for (const auto& cstr : std::vector<std::vector<double>> { {}, { 300.0, 300.0 } }) {
+
+            std::vector<std::array<double, 3>> expected;
+            for (const W& x : all) {
+                if (!detail::pareto_within(x, cstr)) {
+                    continue;
+                }
+                bool dominated = std::any_of(begin(all), end(all), [&](const W& y) {
+                    return detail::pareto_within(y, cstr) && y != x && detail::weakly_dominates(y, x);
+                });
+                if (!dominated) {
+                    expected.push_back(x.m_impl);
+                }
+            }
+            std::sort(begin(expected), end(expected));
+            expected.erase(std::unique(begin(expected), end(expected)), end(expected));
+
+            std::vector<std::array<double, 3>> actual;
+            for (const path& p : pareto_paths(g, m, src, dst, cstr)) {
+                assert(p.front() == src && p.back() == dst);
+                actual.push_back(accumulate_weight(m, p).m_impl);
+            }
+
+            assert(expected.size() > 1);
+            assert(actual == expected);
+        }
     }
 
     void test_larac()
@@ -177,6 +680,71 @@ namespace {
         assert(p == expected_p);
     }
 
+    void test_instrumentation()
+    {
+        using W = array_weight<double, 2>;
+
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; m(reverse(e)) = val; });
+
+        // The counted search finds the same path as the plain one.
+        search_workspace<double> ws { max_node(g) + 1 };
+        counting_stats ds;
+        path pd;
+        dijkstra(g, m, 0, 4, ws, pd, std::less<double> {}, ds);
+        assert(pd == dijkstra(g, m, 0, 4));
+
+        const search_counters& dc = ds.counters;
+        assert(dc.nodes_settled > 0 && dc.nodes_settled <= dc.frontier_pops);
+        assert(dc.frontier_pops <= dc.frontier_pushes);
+        assert(dc.relaxations_improved > 0 && dc.relaxations_improved <= dc.edges_relaxed);
+        assert(dc.frontier_pushes == dc.relaxations_improved + 1);
+        assert(dc.metric_lookups == dc.edges_relaxed);
+        assert(dc.comparisons >= dc.edges_relaxed);
+        assert(dc.larac_iterations == 0);
+
+        // Every round of Bellman-Ford relaxes every edge.
+        counting_stats bs;
+        assert(bellman_ford(g, m, 0, 4, std::less<double> {}, bs) == pd);
+        const std::uint64_t E = std::distance(edge_begin(g), edge_end(g));
+        assert(bs.counters.edges_relaxed == (nodes_count(g) - 1) * E);
+        assert(bs.counters.frontier_pushes == 0);
+
+        // The counters of separate queries aggregate.
+        counting_stats total;
+        total.merge(ds);
+        total.merge(ds);
+        assert(total.counters.edges_relaxed == 2 * dc.edges_relaxed);
+        total.reset();
+        assert(total.counters == search_counters {});
+
+        // LARAC refines the mpiech scenario of test_larac twice.
+        adj_matrix mg;
+        map_metric<W, true> mm;
+        for_each_mpiech_weight([&mg, &mm](const edge& e, const W& w) {
+            mg.set(e); mg.set(reverse(e));
+            mm(e) = w; mm(reverse(e)) = w;
+        });
+        search_workspace<W> lws { max_node(mg) + 1 };
+        counting_stats ls;
+        assert(larac(mg, mm, 1000.0, 0, 7, lws, ls) == larac(mg, mm, 1000.0, 0, 7));
+        assert(ls.counters.larac_iterations == 2);
+        assert(ls.counters.nodes_settled > 0);
+
+        // The per-worker counters of MLRA merge into the same totals
+        // regardless of the number of workers.
+        std::vector<node> dst { 3, 5, 7 };
+        counting_stats ms1, ms4;
+        const tree t1 = mlra(mg, mm, 1000.0, 0, begin(dst), end(dst), 1, ms1);
+        const tree t4 = mlra(mg, mm, 1000.0, 0, begin(dst), end(dst), 4, ms4);
+        assert(t1 == t4 && t1 == mlra(mg, mm, 1000.0, 0, begin(dst), end(dst)));
+        assert(ms1.counters == ms4.counters);
+        assert(ms1.counters.nodes_settled > 0);
+    }
+
     void test_simple()
     {
         adj_list g;
@@ -214,6 +782,15 @@ namespace {
 
         assert(pd == expected_p);
         assert(pb == expected_p);
+
+        // Reuse of a single workspace with the weight returned at the destination.
+        search_workspace<W> ws { max_node(g) + 1 };
+        path pw;
+        for (node dst = 1; dst <= 5; ++dst) {
+            W w = dijkstra(g, m, 0, dst, ws, pw, weight_cmp_cost<W> {});
+            assert(pw == dijkstra(g, m, 0, dst, weight_cmp_cost<W> {}));
+            assert(w == accumulate_weight(m, pw));
+        }
     }
 
     void test_hop()
@@ -230,6 +807,256 @@ namespace {
         assert(nodes_count(pb) == 3);
     }
 
+    void test_k_shortest_paths()
+    {
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+
+        std::vector<double> expected;
+        path current { 0 };
+        brute_force_path_weights(g, m, current, 4, 0.0, expected);
+        std::sort(begin(expected), end(expected));
+
+        for (unsigned threads : { 1u, 4u }) {
+            const int k = 8;
+            std::vector<path> ps = k_shortest_paths(g, m, 0, 4, k, std::less<double> {}, threads);
+            assert(static_cast<int>(ps.size()) == k);
+            assert(ps.front() == dijkstra(g, m, 0, 4));
+            for (int i = 0; i < k; ++i) {
+                assert(ps[i].front() == 0 && ps[i].back() == 4);
+                assert(accumulate_weight(m, ps[i]) == expected[i]);
+                assert(std::count(begin(ps), end(ps), ps[i]) == 1);
+            }
+
+            // Asking for more than there are yields all of them.
+            assert(k_shortest_paths(g, m, 0, 4, 1000, std::less<double> {}, threads).size() == expected.size());
+        }
+    }
+
+    void test_dynamic_sssp()
+    {
+        using W = array_weight<double, 1>;
+
+        adj_list g;
+        map_metric<W> m;
+        fill_random_grid(g, m, 6, 5, 3u);
+
+        const node src = 7;
+        dynamic_sssp<adj_list, map_metric<W>, weight_cmp_cost<W>> dyn { g, m, src };
+
+        std::vector<edge> edges(edge_begin(g), edge_end(g));
+        unsigned seed = 17;
+        auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return seed >> 16; };
+
+        for (int round = 0; round < 200; ++round) {
+            std::vector<std::pair<edge, W>> updates;
+            const int count = 1 + next() % 4;
+            for (int i = 0; i < count; ++i) {
+                const edge& e = edges[next() % edges.size()];
+                updates.emplace_back(e, W { static_cast<double>(next() % 3 + 1) });
+            }
+            dyn.update(begin(updates), end(updates));
+
+            std::vector<node> preds;
+            std::vector<W> dists;
+            detail::dijkstra_relax(g, m, src, preds, dists, detail::never_stop {}, weight_cmp_cost<W> {});
+
+            // The ties of the small integer weights are settled alike.
+            assert(dyn.dists() == dists);
+            assert(dyn.preds() == preds);
+        }
+    }
+
+    void test_spt_cache()
+    {
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+
+        using cache_type = spt_cache<adj_list, map_metric<double, true>>;
+        const std::size_t tree_bytes = sizeof(cache_type::entry) + 6 * (sizeof(node) + sizeof(double));
+        cache_type cache { g, m, 2 * tree_bytes };
+
+        for (int round = 0; round < 2; ++round) {
+            for (node src : { 0, 1 }) {
+                for (node dst = 0; dst < 6; ++dst) {
+                    assert(cache.query(src, dst) == dijkstra(g, m, src, dst));
+                }
+            }
+        }
+        assert(cache.misses() == 2);
+        assert(cache.hits() == 22);
+        assert(cache.bytes() <= 2 * tree_bytes);
+
+        // The third source evicts the least recently used one.
+        assert(cache.query(2, 4) == dijkstra(g, m, 2, 4));
+        assert(cache.query(1, 4) == dijkstra(g, m, 1, 4));
+        assert(cache.query(0, 4) == dijkstra(g, m, 0, 4));
+        assert(cache.misses() == 4);
+
+        // Other comparators are cached separately.
+        assert(cache.query(0, 4, weight_cmp_less<double> {}) == dijkstra(g, m, 0, 4));
+        assert(cache.misses() == 5);
+
+        // Metric writes invalidate the cache.
+        m(edge { 2, 5 }) = 100.0;
+        assert(cache.query(0, 4) == dijkstra(g, m, 0, 4));
+        assert(cache.query(0, 4) != (path { 0, 2, 5, 4 }));
+        assert(cache.misses() == 6);
+
+        // The reads through a const reference keep the cache.
+        const auto& cm = m;
+        assert(cm(edge { 2, 5 }) == 100.0);
+        assert(cache.query(0, 4) == dijkstra(g, m, 0, 4));
+        assert(cache.misses() == 6);
+    }
+
+    void test_parallel_bellman_ford()
+    {
+        using W = array_weight<double, 2>;
+
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<double, true> m;
+        map_metric<W, true> mm;
+        for_each_example_metric_dbl([&m, &mm](const edge& e, double val) {
+            m(e) = val;
+            mm(e) = W { 10 * val, val };
+        });
+
+        path expected_p { 0, 2, 5, 4 };
+
+        for (unsigned threads : { 1u, 2u, 4u }) {
+            path p = parallel_bellman_ford(g, m, 0, 4, std::less<double> {}, threads);
+            path pm = parallel_bellman_ford(g, mm, 0, 4, weight_cmp_cost<W> {}, threads);
+            assert(p == expected_p);
+            assert(pm == expected_p);
+        }
+
+        // Directed graph with negative weights.
+        adj_list ng;
+        map_metric<int> nm;
+        for (const auto& pr : std::vector<std::pair<edge, int>> {
+                { { 0, 1 }, 4 }, { { 0, 2 }, 5 }, { { 1, 3 }, 3 },
+                { { 2, 1 }, -3 }, { { 3, 4 }, 2 }, { { 2, 4 }, 4 } }) {
+            ng.set(pr.first);
+            nm(pr.first) = pr.second;
+        }
+
+        std::vector<node> preds, par_preds;
+        std::vector<int> dists, par_dists;
+        detail::bellman_ford_relax(ng, nm, 0, preds, dists, std::less<int> {});
+        detail::parallel_bellman_ford_relax(ng, nm, 0, par_preds, par_dists, std::less<int> {}, 3);
+
+        assert(dists == par_dists);
+        assert(preds == par_preds);
+
+        for (unsigned threads : { 1u, 2u, 5u }) {
+            assert(parallel_accumulate_weight(m, g, threads) == accumulate_weight(m, g));
+            assert(parallel_accumulate_weight(mm, g, threads) == accumulate_weight(mm, g));
+        }
+    }
+
+    void test_thread_pool()
+    {
+        thread_pool pool { 3 };
+        assert(pool.size() == 3);
+
+        // Every index is visited exactly once.
+        std::vector<std::atomic<int>> visits(1000);
+        pool.parallel_for(0, visits.size(), 7, [&visits](std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i) {
+                ++visits[i];
+            }
+        });
+        assert(std::all_of(begin(visits), end(visits), [](const std::atomic<int>& x) { return x == 1; }));
+
+        // Nested fork/join does not deadlock.
+        std::atomic<int> leaves { 0 };
+        {
+            thread_pool::task_group outer { pool };
+            for (int i = 0; i < 8; ++i) {
+                outer.run([&pool, &leaves] {
+                    thread_pool::task_group inner { pool };
+                    for (int j = 0; j < 8; ++j) {
+                        inner.run([&leaves] { ++leaves; });
+                    }
+                    inner.wait();
+                });
+            }
+            outer.wait();
+        }
+        assert(leaves == 64);
+
+        // The exceptions are propagated to the joining thread.
+        bool thrown = false;
+        try {
+            thread_pool::task_group group { pool };
+            group.run([] { throw std::runtime_error("task"); });
+            group.wait();
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        // The injected pool is used by the algorithms.
+        {
+            thread_pool::scoped_pool scope { pool };
+            assert(&thread_pool::current() == &pool);
+            assert(detail::worker_count(0) == 3);
+            std::atomic<int> on_pool { 0 };
+            detail::parallel_for_each_index(16, 4, [&pool, &on_pool](unsigned, std::size_t) {
+                if (&thread_pool::current() == &pool) {
+                    ++on_pool;
+                }
+            });
+            assert(on_pool == 16);
+
+            adj_list g;
+            prepare_wiki_graph(g);
+            map_metric<double, true> m;
+            for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+            assert(parallel_bellman_ford(g, m, 0, 4) == (path { 0, 2, 5, 4 }));
+        }
+        assert(&thread_pool::current() == &thread_pool::default_pool());
+    }
+
+    void test_mst()
+    {
+        using W = array_weight<double, 2>;
+
+        adj_list g;
+        prepare_wiki_graph(g);
+
+        map_metric<W, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) {
+            m(e) = W { val, 100.0 - val };
+        });
+
+        tree expected_t {{
+            { 0, 1 }, { 0, 2 }, { 2, 5 }, { 5, 4 }, { 4, 3 }
+        }};
+
+        tree tp = prim(g, m, 0, weight_cmp_cost<W> {});
+        tree tk = kruskal(g, m, weight_cmp_cost<W> {});
+        tree tb1 = boruvka(g, m, weight_cmp_cost<W> {}, 1);
+        tree tb4 = boruvka(g, m, weight_cmp_cost<W> {}, 4);
+
+        assert(all_equal(expected_t, tp, tk, tb1, tb4));
+        assert(accumulate_cost(m, tp) == 33.0);
+
+        // The shortest path tree differs from the minimum spanning tree here.
+        tree ts = shortest_path_tree(g, m, 0, weight_cmp_cost<W> {});
+        assert(ts != tp);
+        assert(accumulate_cost(m, ts) > 33.0);
+    }
+
 }
 
 void test_algorithm()
@@ -238,8 +1065,22 @@ void test_algorithm()
     test_simple();
     test_multi();
     test_hop();
+    test_thread_pool();
+    test_parallel_bellman_ford();
+    test_k_shortest_paths();
+    test_dynamic_sssp();
+    test_spt_cache();
+    test_mst();
 
     // Test custom algorithms.
     test_larac();
+    test_instrumentation();
     test_mlra();
+    test_larac_tree();
+    test_tree_index();
+    test_steiner();
+    test_failure_impact();
+    test_connectivity();
+    test_lbpsa();
+    test_pareto();
 }
@@ -3,6 +3,7 @@
 
 #include <map>
 #include <deque>
+#include <vector>
 #include <iostream>
 
 #include "config.h"
@@ -109,5 +110,6 @@ void for_each_example_metric_dbl(Func f)
 void test_metric();
 void test_topology();
 void test_algorithm();
+void test_server();
 
 #endif
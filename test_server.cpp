@@ -0,0 +1,204 @@
+#include <thread>
+#include <cassert>
+#include <sstream>
+#include <unistd.h>
+
+#include "test_common.h"
+#include "weight.h"
+#include "metric.h"
+#include "topology.h"
+#include "graph_io.h"
+#include "server.h"
+
+namespace {
+
+    using W = array_weight<double, 2>;
+    using graph_type = adj_list;
+    using metric_type = map_metric<W, true>;
+
+    void load_example(graph_type& g, metric_type& m)
+    {
+        std::stringstream text;
+        text << "# cost delay\n\n";
+        for_each_example_metric_dbl([&text](const edge& e, double val) {
+            text << e.first << " " << e.second << " " << val << " " << 20.0 - val << "\n";
+        });
+        load_graph(text, g, m);
+    }
+
+    void graph_io_test()
+    {
+        graph_type g;
+        metric_type m;
+        load_example(g, m);
+        assert(m(edge { 2, 0 }) == (W { 9.0, 11.0 }));
+        assert(out_end(g, 4) - out_begin(g, 4) == 2);
+
+        std::stringstream bad { "0 1 1.0 2.0 3.0\n" };
+        bool thrown = false;
+        try {
+            load_graph(bad, g, m);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    void query_test()
+    {
+        graph_type g;
+        metric_type m;
+        load_example(g, m);
+
+        server_options options;
+        options.socket_path = "/tmp/top_server_test." + std::to_string(::getpid());
+        options.threads = 2;
+        route_server<graph_type, metric_type> server { g, m, options };
+        server.start();
+
+        {
+            route_client client { options.socket_path };
+
+            auto r = client.dijkstra(0, 4);
+            assert(r.status == server_status::ok);
+            assert(r.p == dijkstra(g, m, 0, 4, weight_cmp_cost<W> {}));
+            assert(r.cost == 20.0 && r.delay == 40.0);
+
+            r = client.larac(0, 4, 30.0);
+            assert(r.status == server_status::ok);
+            assert(r.p == larac(g, m, 30.0, 0, 4));
+            assert(r.delay <= 30.0);
+
+            assert(client.larac(0, 4, 1.0).status == server_status::no_path);
+            assert(client.dijkstra(0, 42).status == server_status::bad_request);
+
+            const std::vector<node> dsts { 3, 4 };
+            r = client.mlra(0, 30.0, dsts);
+            assert(r.status == server_status::ok);
+            const tree expected = mlra(g, m, 30.0, 0, begin(dsts), end(dsts));
+            assert(r.edges == std::vector<edge>(edge_begin(expected), edge_end(expected)));
+        }
+
+        // Many clients pipelining their requests get the responses in order.
+        std::vector<std::thread> clients;
+        for (int c = 0; c < 4; ++c) {
+            clients.emplace_back([&options, c] {
+                route_client client { options.socket_path };
+                std::string args;
+                detail::frame_put(args, std::uint32_t(c));
+                detail::frame_put(args, std::uint32_t(4));
+                for (int i = 0; i < 100; ++i) {
+                    client.send(server_op::dijkstra, args);
+                }
+                for (std::uint32_t i = 0; i < 100; ++i) {
+                    auto r = client.receive(server_op::dijkstra);
+                    assert(r.first == i);
+                    assert(r.second.status == server_status::ok && r.second.p.back() == 4);
+                }
+            });
+        }
+        for (auto& c : clients) {
+            c.join();
+        }
+
+        // A frame without an operation is rejected and not accounted.
+        {
+            const sockaddr_un address = detail::socket_address(options.socket_path);
+            const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            assert(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+            std::string frame = detail::frame_start(7);
+            detail::frame_finish(frame);
+            assert(detail::socket_write(fd, frame.data(), frame.size()));
+            std::string response;
+            assert(detail::socket_read_frame(fd, response, 1 << 10));
+            assert(response.size() == sizeof(std::uint32_t) + 1);
+            assert(static_cast<server_status>(response.back()) == server_status::bad_request);
+            ::close(fd);
+        }
+
+        {
+            route_client client { options.socket_path };
+            auto r = client.stats();
+            assert(r.status == server_status::ok);
+            assert(r.buckets.size() == 3 * latency_histogram::bucket_count);
+        }
+        assert(server.latency(server_op::dijkstra).count() == 402);
+        assert(server.latency(server_op::larac).count() == 2);
+        assert(server.latency(server_op::mlra).count() == 1);
+
+        server.stop();
+    }
+
+    void backpressure_test()
+    {
+        graph_type g;
+        metric_type m;
+        load_example(g, m);
+
+        server_options options;
+        options.socket_path = "/tmp/top_server_test." + std::to_string(::getpid());
+        options.batch_size = 1;
+        options.queue_capacity = 1;
+        route_server<graph_type, metric_type> server { g, m, options };
+        server.start();
+
+        // The sender is throttled by the full queue, but nothing is lost.
+        route_client client { options.socket_path };
+        std::thread sender { [&client] {
+            std::string args;
+            detail::frame_put(args, std::uint32_t(0));
+            detail::frame_put(args, std::uint32_t(4));
+            for (int i = 0; i < 1000; ++i) {
+                client.send(server_op::dijkstra, args);
+            }
+        } };
+        for (std::uint32_t i = 0; i < 1000; ++i) {
+            assert(client.receive(server_op::dijkstra).first == i);
+        }
+        sender.join();
+    }
+
+    void stalled_client_test()
+    {
+        graph_type g;
+        metric_type m;
+        load_example(g, m);
+
+        server_options options;
+        options.socket_path = "/tmp/top_server_test." + std::to_string(::getpid());
+        options.queue_capacity = 16;
+        options.max_pending = 1 << 16;
+        route_server<graph_type, metric_type> server { g, m, options };
+        server.start();
+
+        // A client pipelining without reading is disconnected, the others
+        // are still answered.
+        route_client stalled { options.socket_path };
+        std::thread sender { [&stalled] {
+            std::string args;
+            detail::frame_put(args, std::uint32_t(0));
+            detail::frame_put(args, std::uint32_t(4));
+            try {
+                for (int i = 0; i < 200000; ++i) {
+                    stalled.send(server_op::dijkstra, args);
+                }
+            } catch (const std::runtime_error&) {
+            }
+        } };
+        {
+            route_client client { options.socket_path };
+            assert(client.dijkstra(0, 4).status == server_status::ok);
+        }
+        sender.join();
+        server.stop();
+    }
+
+}
+
+void test_server()
+{
+    graph_io_test();
+    query_test();
+    backpressure_test();
+    stalled_client_test();
+}
@@ -1,10 +1,19 @@
+#include <thread>
+#include <atomic>
 #include <cassert>
+#include <stdexcept>
 
 #include "test_common.h"
 #include "metric.h"
 #include "weight.h"
+#include "weight_util.h"
 #include "algorithms_basic.h"
 #include "topology.h"
+#include "snapshot.h"
+#include "topology_csr.h"
+#include "generators.h"
+#include "topology_compressed.h"
+#include "topology_view.h"
 
 namespace {
 
@@ -27,7 +36,7 @@ namespace {
             1, 0, 1, 0, 1, 0 };
         adj_matrix adj_mat;
         fill_example_graph_bi(adj_mat);
-        assert(adj_mat.matrix == expected_adj_mat);
+        assert(adj_mat == adj_matrix(begin(expected_adj_mat), end(expected_adj_mat)));
 
         std::vector<std::vector<node>> expected_adj_list {
             { 1, 2, 5 },
@@ -61,11 +70,425 @@ namespace {
         assert(expected_tresult == tresult);
     }
 
+    void snapshot_test()
+    {
+        using manager_type = snapshot_manager<adj_list, map_metric<double, true>>;
+
+        // Every version scales the example weights by its number plus one.
+        auto make_version = [](manager_type::snapshot& s, double scale) {
+            for_each_example_metric_dbl([&s, scale](const edge& e, double val) {
+                s.metric(e) = scale * val;
+            });
+        };
+
+        manager_type::snapshot initial;
+        fill_example_graph_bi(initial.topology);
+        make_version(initial, 1.0);
+        manager_type manager { std::move(initial), 4 };
+
+        // A pinned snapshot survives the publishing of its successors.
+        {
+            auto reader = manager.register_reader();
+            auto pinned = reader.acquire();
+            auto next = manager.prepare();
+            make_version(next, 2.0);
+            assert(manager.publish(std::move(next)) == 1);
+            manager.collect();
+            assert(manager.retired_count() == 1);
+            assert(pinned->version == 0);
+            assert(pinned.metric()(edge { 0, 2 }) == 9.0);
+        }
+        manager.collect();
+        assert(manager.retired_count() == 0);
+
+        // The readers query consistent versions while the writer publishes.
+        std::atomic<bool> done { false };
+        std::vector<std::thread> readers;
+        for (int i = 0; i < 3; ++i) {
+            readers.emplace_back([&manager, &done] {
+                auto reader = manager.register_reader();
+                do {
+                    auto pinned = reader.acquire();
+                    const path p = dijkstra(pinned.topology(), pinned.metric(), 0, 4);
+                    assert((p == path { 0, 2, 5, 4 }));
+                    double cost = 0.0;
+                    for (std::size_t j = 1; j < p.size(); ++j) {
+                        cost += pinned.metric()(edge { p[j - 1], p[j] });
+                    }
+                    assert(cost == 20.0 * (pinned->version + 1));
+                } while (!done.load());
+            });
+        }
+        for (int v = 2; v < 50; ++v) {
+            auto next = manager.prepare();
+            make_version(next, v + 1.0);
+            assert(manager.publish(std::move(next)) == static_cast<std::size_t>(v));
+        }
+        done.store(true);
+        for (auto& r : readers) {
+            r.join();
+        }
+        manager.collect();
+        assert(manager.retired_count() == 0);
+    }
+
+    void csr_test()
+    {
+        std::vector<edge> edges;
+        for_each_example_metric_dbl([&edges](const edge& e, double) { edges.push_back(e); });
+
+        adj_list adj;
+        fill_example_graph_bi(adj);
+        const csr_graph csr { 6, edges, true };
+
+        assert(nodes_count(csr) == 6);
+        assert(max_node(csr) == 5);
+        assert(csr.edges_count() == 2 * edges.size());
+        for (node u = 0; u < 6; ++u) {
+            std::vector<node> expected(out_begin(adj, u), out_end(adj, u));
+            std::sort(begin(expected), end(expected));
+            assert(std::vector<node>(out_begin(csr, u), out_end(csr, u)) == expected);
+        }
+        assert(csr.edge_index(2, 5) != csr.edges_count());
+        assert(csr.edge_index(0, 4) == csr.edges_count());
+
+        // The edges iterate in order and support the random access.
+        const std::vector<edge> all(edge_begin(csr), edge_end(csr));
+        assert(all.size() == csr.edges_count());
+        assert(std::is_sorted(begin(all), end(all)));
+        assert(edge_begin(csr)[5] == all[5]);
+        assert(*(edge_end(csr) - 1) == all.back());
+
+        csr_metric<double> m { csr };
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; m(reverse(e)) = val; });
+        assert((dijkstra(csr, m, 0, 4) == path { 0, 2, 5, 4 }));
+
+        // The edges missing from the graph have no weight.
+        const std::size_t before = version(m);
+        bool thrown = false;
+        try {
+            m(edge { 0, 4 }) = 1.0;
+        } catch (const std::out_of_range&) {
+            thrown = true;
+        }
+        assert(thrown && version(m) == before);
+
+        // Isolated nodes at both ends.
+        const csr_graph sparse { 5, { { 2, 3 } }, false };
+        assert(std::vector<edge>(edge_begin(sparse), edge_end(sparse)) == (std::vector<edge> { { 2, 3 } }));
+        assert(out_begin(sparse, 4) == out_end(sparse, 4));
+    }
+
+    void compressed_test()
+    {
+        using W = array_weight<double, 2>;
+
+        // The example graph, with an isolated node between and after.
+        std::vector<edge> edges;
+        for_each_example_metric_dbl([&edges](const edge& e, double) { edges.push_back(e); });
+        edges.push_back({ 7, 1 });
+        const csr_graph csr { 9, edges, true };
+        const compressed_graph small { csr };
+        assert(nodes_count(small) == 9 && max_node(small) == 8);
+        for (node u = 0; u < 9; ++u) {
+            assert(std::vector<node>(out_begin(small, u), out_end(small, u)) == std::vector<node>(out_begin(csr, u), out_end(csr, u)));
+        }
+        assert(std::vector<edge>(edge_begin(small), edge_end(small)) == std::vector<edge>(edge_begin(csr), edge_end(csr)));
+        assert(out_begin(small, 6) == out_end(small, 6));
+        assert(edge_begin(compressed_graph {}) == edge_end(compressed_graph {}));
+
+        // The searches run over it unchanged.
+        csr_graph g;
+        csr_metric<W> m;
+        generate_grid(40, 40, 3, g, m);
+        const compressed_graph c { g };
+        assert(std::vector<edge>(edge_begin(c), edge_end(c)) == std::vector<edge>(edge_begin(g), edge_end(g)));
+
+        search_workspace<W> ws { nodes_count(g) };
+        path pg, pc;
+        for (node dst : { 1, 39, 820, 1599 }) {
+            const W wg = dijkstra(g, m, 0, dst, ws, pg, weight_cmp_cost<W> {});
+            const W wc = dijkstra(c, m, 0, dst, ws, pc, weight_cmp_cost<W> {});
+            assert(pg == pc && wg == wc);
+        }
+        const csr_graph ring { 50, { { 0, 1 }, { 1, 2 }, { 2, 49 }, { 49, 3 } }, true };
+        csr_metric<double> rm { ring, 1.0 };
+        assert(bellman_ford(compressed_graph { ring }, rm, 0, 3) == (path { 0, 1, 2, 49, 3 }));
+
+        // The grid gaps take a byte or two instead of the node and offset.
+        assert(3 * memory_usage(c).total() <= memory_usage(g).total());
+
+        // The high degree nodes and the long gaps of a random graph.
+        csr_graph ba;
+        csr_metric<W> bam;
+        generate_barabasi_albert(3000, 3, 11, ba, bam);
+        const compressed_graph cba { ba, 4 };
+        for (node u = 0; u < nodes_count(ba); ++u) {
+            assert(std::equal(out_begin(ba, u), out_end(ba, u), out_begin(cba, u)));
+            assert(std::distance(out_begin(cba, u), out_end(cba, u)) == out_end(ba, u) - out_begin(ba, u));
+        }
+        assert(memory_usage(cba).total() < memory_usage(ba).total());
+    }
+
+    void memory_test()
+    {
+        adj_list g;
+        fill_example_graph_bi(g);
+        const std::size_t E = std::distance(edge_begin(g), edge_end(g));
+
+        const memory_footprint gm = memory_usage(g);
+        assert(gm.payload == E * sizeof(node));
+        assert(gm.overhead >= g.adjacency.size() * sizeof(std::vector<node>));
+        assert(gm.total() == gm.payload + gm.overhead + gm.slack);
+
+        // The reserved capacity shows as slack only.
+        g.adjacency[0].reserve(g.adjacency[0].size() + 100);
+        const memory_footprint rm = memory_usage(g);
+        assert(rm.payload == gm.payload);
+        assert(rm.slack > gm.slack && rm.slack >= 100 * sizeof(node));
+
+        // The map nodes cost more than their values.
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+        const memory_footprint mm = memory_usage(m);
+        assert(mm.payload == (E / 2) * sizeof(std::pair<const edge, double>));
+        assert(mm.overhead > mm.payload && mm.slack == 0);
+
+        std::vector<edge> edges;
+        for_each_example_metric_dbl([&edges](const edge& e, double) { edges.push_back(e); });
+        const csr_graph csr { 6, edges, true };
+        const csr_metric<double> cm { csr };
+        assert(memory_usage(csr).payload == 7 * sizeof(std::size_t) + E * sizeof(node));
+        assert(memory_usage(csr).slack == 0);
+        assert(memory_usage(cm).payload == E * sizeof(double));
+        assert(memory_usage(cm).total() < mm.total());
+
+        adj_matrix mat;
+        fill_example_graph_bi(mat);
+        assert(memory_usage(mat).payload == (36 + 7) / 8);
+
+        const path p { 0, 2, 5, 4 };
+        assert(memory_usage(p).payload == 4 * sizeof(node));
+        const tree t = shortest_path_tree(g, m, 0);
+        const std::size_t T = std::distance(edge_begin(t), edge_end(t));
+        assert(memory_usage(t).payload == T * sizeof(std::pair<const node, node>));
+
+        search_workspace<double> ws { 6 };
+        const memory_footprint wm = memory_usage(ws);
+        assert(wm.payload == 6 * (sizeof(node) + sizeof(double)));
+        assert(wm.slack >= 6 * sizeof(search_workspace<double>::entry));
+
+        // The counting allocator keeps the peak of the live bytes.
+        allocation_counter counter;
+        {
+            std::vector<node, counting_allocator<node>> v { counting_allocator<node> { counter } };
+            for (node n = 0; n < 100; ++n) {
+                v.push_back(n);
+            }
+            assert(counter.current >= 100 * sizeof(node));
+        }
+        assert(counter.current == 0);
+        assert(counter.peak >= 100 * sizeof(node) && counter.allocations > 1);
+        counter.reset();
+        assert(counter.peak == 0 && counter.allocations == 0);
+    }
+
+    void bulk_test()
+    {
+        std::vector<edge> edges;
+        for_each_example_metric_dbl([&edges](const edge& e, double) {
+            edges.push_back(e);
+            edges.push_back(reverse(e));
+        });
+
+        // The bulk construction equals the edges set one by one.
+        adj_list g;
+        fill_example_graph_bi(g);
+        const adj_list bulk_g { begin(edges), end(edges) };
+        assert(bulk_g == g);
+        for (const auto& neighbors : bulk_g.adjacency) {
+            assert(neighbors.capacity() == neighbors.size());
+        }
+
+        adj_matrix mat;
+        fill_example_graph_bi(mat);
+        const adj_matrix bulk_mat { begin(edges), end(edges) };
+        assert(bulk_mat == mat);
+        assert(memory_usage(bulk_mat).payload == memory_usage(mat).payload);
+
+        tree t = shortest_path_tree(g, hop_metric<double> {}, 0);
+        assert(tree(edge_begin(t), edge_end(t)) == t);
+
+        // The parallel edges are stored once on demand.
+        std::vector<edge> doubled = edges;
+        doubled.insert(end(doubled), begin(edges), end(edges));
+        assert(adj_list(begin(doubled), end(doubled)) != g);
+        adj_list dedup_g;
+        dedup_g.assign(begin(doubled), end(doubled), true);
+        assert(std::distance(edge_begin(dedup_g), edge_end(dedup_g)) == std::distance(begin(edges), end(edges)));
+        for (node u = 0; u < 6; ++u) {
+            assert(std::is_permutation(out_begin(dedup_g, u), out_end(dedup_g, u), out_begin(g, u)));
+        }
+        assert(adj_matrix(begin(doubled), end(doubled)) == mat);
+
+        // The rows grow geometrically with the nodes added one by one and
+        // the presized structure accepts the edges in place.
+        adj_matrix chain;
+        for (node u = 0; u < 1000; ++u) {
+            chain.set({ u, u + 1 });
+        }
+        assert(nodes_count(chain) == 1001);
+        assert(chain.stride >= 1001 && chain.stride < 2002);
+        assert(std::distance(edge_begin(chain), edge_end(chain)) == 1000);
+        assert(memory_usage(chain).slack > 0);
+
+        adj_matrix presized { 8 };
+        presized.set({ 7, 0 });
+        assert(presized.stride == 8 && nodes_count(presized) == 8);
+        assert(std::distance(out_begin(presized, 7), out_end(presized, 7)) == 1);
+        presized.reserve(16);
+        assert(presized.stride == 16 && presized.has(7, 0));
+
+        adj_list reserved;
+        reserved.reserve(10);
+        assert(reserved.adjacency.capacity() >= 10);
+        assert(reserved == adj_list {} && version(reserved) == 0);
+        reserved.assign(begin(edges), end(edges));
+        assert(reserved == g);
+    }
+
+    void view_test()
+    {
+        adj_list g;
+        fill_example_graph_bi(g);
+        map_metric<double, true> m;
+        for_each_example_metric_dbl([&m](const edge& e, double val) { m(e) = val; });
+        const auto E = std::distance(edge_begin(g), edge_end(g));
+
+        const topology_view<adj_list> all { g };
+        assert(std::distance(edge_begin(all), edge_end(all)) == E);
+        assert(max_node(all) == 5 && nodes_count(all) == 6);
+        assert((dijkstra(all, m, 0, 4) == path { 0, 2, 5, 4 }));
+
+        // The failed link in both directions.
+        const topology_view<adj_list> link { g, nullptr, { { 2, 5 }, { 5, 2 } } };
+        assert(std::distance(edge_begin(link), edge_end(link)) == E - 2);
+        assert(std::find(out_begin(link, 2), out_end(link, 2), 5) == out_end(link, 2));
+        assert((dijkstra(link, m, 0, 4) == path { 0, 5, 4 }));
+
+        // A single direction only.
+        const topology_view<adj_list> arc { g, nullptr, { { 2, 5 } } };
+        assert(std::distance(edge_begin(arc), edge_end(arc)) == E - 1);
+        assert((dijkstra(arc, m, 4, 0) == path { 4, 5, 2, 0 }));
+
+        // The failed node loses all its edges, the mask is shared.
+        std::vector<char> removed(6, false);
+        removed[5] = true;
+        const topology_view<adj_list> nodes { g, &removed };
+        assert(out_begin(nodes, 5) == out_end(nodes, 5));
+        assert(std::distance(edge_begin(nodes), edge_end(nodes)) == E - 6);
+        assert((dijkstra(nodes, m, 0, 4) == path { 0, 2, 3, 4 }));
+        assert(version(nodes) == version(g) && memory_usage(nodes).payload == 0);
+
+        // The edges accepted by a predicate.
+        const auto cheap = filter_edges(g, [&m](const edge& e) { return m(e) < 9.0; });
+        assert((std::vector<node>(out_begin(cheap, 0), out_end(cheap, 0)) == std::vector<node> { 1 }));
+        assert(std::distance(edge_begin(cheap), edge_end(cheap)) == 6);
+        assert(std::all_of(edge_begin(cheap), edge_end(cheap), [&m](const edge& e) { return m(e) < 9.0; }));
+    }
+
+    template <typename Generate>
+    void check_generator(Generate generate)
+    {
+        using W = array_weight<double, 2>;
+
+        csr_graph g1, g3;
+        csr_metric<W> m1, m3;
+        generate(g1, m1, 1u);
+        generate(g3, m3, 3u);
+
+        // Independent of the number of the workers.
+        assert(g1 == g3);
+        assert(m1 == m3);
+
+        // Undirected, loopless and with the weights in range.
+        std::for_each(edge_begin(g1), edge_end(g1), [&](const edge& e) {
+            assert(e.first != e.second);
+            assert(g1.edge_index(e.second, e.first) != g1.edges_count());
+            assert(m1(e) == m1(reverse(e)));
+            assert(m1(e)[0] >= 1.0 && m1(e)[0] <= 100.0);
+            assert(m1(e)[1] >= 1.0 && m1(e)[1] <= 100.0);
+        });
+    }
+
+    void generators_test()
+    {
+        using W = array_weight<double, 2>;
+
+        check_generator([](csr_graph& g, csr_metric<W>& m, unsigned threads) {
+            generate_grid(70, 80, 1, g, m, threads);
+        });
+        check_generator([](csr_graph& g, csr_metric<W>& m, unsigned threads) {
+            generate_erdos_renyi(5000, 0.002, 2, g, m, threads);
+        });
+        check_generator([](csr_graph& g, csr_metric<W>& m, unsigned threads) {
+            generate_barabasi_albert(9000, 3, 3, g, m, threads);
+        });
+        check_generator([](csr_graph& g, csr_metric<W>& m, unsigned threads) {
+            generate_waxman(600, 0.4, 0.1, 4, g, m, threads);
+        });
+        check_generator([](csr_graph& g, csr_metric<W>& m, unsigned threads) {
+            generate_random_geometric(5000, 0.03, 5, g, m, threads);
+        });
+
+        csr_graph g;
+        csr_metric<W> m;
+
+        generate_grid(70, 80, 1, g, m);
+        assert(nodes_count(g) == 70 * 80);
+        assert(g.edges_count() == 2 * (69 * 80 + 70 * 79));
+
+        generate_erdos_renyi(5000, 0.002, 2, g, m);
+        const double expected = 0.002 * 5000.0 * 4999.0;
+        assert(std::abs(g.edges_count() - expected) < 0.05 * expected);
+
+        // The preferential attachment yields hubs; every late node keeps
+        // at least one edge to an earlier node.
+        generate_barabasi_albert(9000, 3, 3, g, m);
+        std::size_t max_degree = 0;
+        for (node u = 0; u < 9000; ++u) {
+            max_degree = std::max<std::size_t>(max_degree, out_end(g, u) - out_begin(g, u));
+            assert(u == 0 || *out_begin(g, u) < u);
+        }
+        assert(max_degree > 50);
+
+        generate_random_geometric(5000, 0.03, 5, g, m);
+        std::for_each(edge_begin(g), edge_end(g), [](const edge& e) {
+            assert(detail::gen_distance(detail::gen_point(5, e.first), detail::gen_point(5, e.second)) < 0.03);
+        });
+        std::size_t brute = 0;
+        for (node u = 0; u < 1000; ++u) {
+            for (node v = 0; v < 5000; ++v) {
+                if (u != v && detail::gen_distance(detail::gen_point(5, u), detail::gen_point(5, v)) < 0.03) {
+                    ++brute;
+                }
+            }
+        }
+        assert(brute == g.offsets[1000]);
+    }
+
 }
 
 void test_topology()
 {
     initialization_test();
     non_graph_path_finding_test();
+    snapshot_test();
+    csr_test();
+    memory_test();
+    compressed_test();
+    bulk_test();
+    view_test();
+    generators_test();
 }
 
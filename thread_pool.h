@@ -0,0 +1,315 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/// The work-stealing pool of the worker threads shared by all the parallel
+/// algorithms.
+///
+/// Every worker owns a deque of tasks: it pushes and pops its own tasks at
+/// the back and steals from the front of the other workers' deques when it
+/// runs out of work. The tasks submitted from outside of the pool go through
+/// a shared injection queue. A thread waiting for its tasks to finish
+/// executes the pending tasks in the meantime, hence the fork/join
+/// parallelism may be nested without deadlocks.
+class thread_pool {
+
+public:
+    using task = std::function<void()>;
+
+private:
+    struct worker_queue {
+        std::mutex guard;
+        std::deque<task> tasks;
+    };
+
+    std::vector<std::unique_ptr<worker_queue>> m_queues;
+    worker_queue m_injected;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sleep;
+    std::condition_variable m_wake;
+    std::atomic<std::size_t> m_queued { 0 };
+    bool m_stop = false;
+
+    /// The pool and the index of the worker run by the calling thread.
+    static std::pair<const thread_pool*, std::size_t>& this_worker()
+    {
+        static thread_local std::pair<const thread_pool*, std::size_t> w { nullptr, 0 };
+        return w;
+    }
+
+    bool pop_back(worker_queue& q, task& out)
+    {
+        std::lock_guard<std::mutex> lock { q.guard };
+        if (q.tasks.empty()) {
+            return false;
+        }
+        out = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        return true;
+    }
+
+    bool pop_front(worker_queue& q, task& out)
+    {
+        std::lock_guard<std::mutex> lock { q.guard };
+        if (q.tasks.empty()) {
+            return false;
+        }
+        out = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+
+    /// Takes a task: the own newest one first, then the injected ones, then
+    /// the oldest ones of the other workers.
+    bool take(task& out)
+    {
+        const auto& self = this_worker();
+        const bool inside = self.first == this;
+        const std::size_t n = m_queues.size();
+        bool found = (inside && pop_back(*m_queues[self.second], out)) || pop_front(m_injected, out);
+        for (std::size_t i = 1; !found && i <= n; ++i) {
+            found = pop_front(*m_queues[(self.second + i) % n], out);
+        }
+        if (found) {
+            m_queued.fetch_sub(1);
+        }
+        return found;
+    }
+
+    void work(std::size_t index)
+    {
+        this_worker() = { this, index };
+        task t;
+        for (;;) {
+            if (take(t)) {
+                t();
+                t = nullptr;
+                continue;
+            }
+            std::unique_lock<std::mutex> lock { m_sleep };
+            m_wake.wait(lock, [this] { return m_stop || m_queued.load() > 0; });
+            if (m_stop && m_queued.load() == 0) {
+                return;
+            }
+        }
+    }
+
+public:
+    /// @param threads The number of the worker threads, zero for the number
+    ///                of the hardware threads.
+    explicit thread_pool(unsigned threads = 0)
+    {
+        if (!threads) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned i = 0; i < threads; ++i) {
+            m_queues.emplace_back(new worker_queue);
+        }
+        for (unsigned i = 0; i < threads; ++i) {
+            m_threads.emplace_back([this, i] { work(i); });
+        }
+    }
+
+    ~thread_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock { m_sleep };
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& th : m_threads) {
+            th.join();
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /// The number of the worker threads.
+    unsigned size() const { return static_cast<unsigned>(m_threads.size()); }
+
+    /// Schedules a task; a worker pushes it to its own deque.
+    void submit(task t)
+    {
+        const auto& self = this_worker();
+        worker_queue& q = self.first == this ? *m_queues[self.second] : m_injected;
+        {
+            std::lock_guard<std::mutex> lock { q.guard };
+            q.tasks.push_back(std::move(t));
+        }
+        {
+            std::lock_guard<std::mutex> lock { m_sleep };
+            m_queued.fetch_add(1);
+        }
+        m_wake.notify_one();
+    }
+
+    /// Executes one pending task, if any, on the calling thread.
+    bool run_pending()
+    {
+        task t;
+        if (!take(t)) {
+            return false;
+        }
+        t();
+        return true;
+    }
+
+    /// The set of the forked tasks joined together.
+    class task_group {
+
+        thread_pool& m_pool;
+        std::atomic<std::size_t> m_pending { 0 };
+        std::mutex m_error_guard;
+        std::exception_ptr m_error;
+
+    public:
+        explicit task_group(thread_pool& pool) : m_pool { pool } {}
+
+        task_group(const task_group&) = delete;
+        task_group& operator=(const task_group&) = delete;
+
+        ~task_group()
+        {
+            while (m_pending.load()) {
+                if (!m_pool.run_pending()) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        /// Forks a task.
+        template <typename F>
+        void run(F f)
+        {
+            m_pending.fetch_add(1);
+            m_pool.submit([this, f]() mutable {
+                try {
+                    f();
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock { m_error_guard };
+                    if (!m_error) {
+                        m_error = std::current_exception();
+                    }
+                }
+                m_pending.fetch_sub(1);
+            });
+        }
+
+        /// Joins the forked tasks, executing the pending tasks meanwhile;
+        /// rethrows the first exception thrown by them.
+        void wait()
+        {
+            while (m_pending.load()) {
+                if (!m_pool.run_pending()) {
+                    std::this_thread::yield();
+                }
+            }
+            if (m_error) {
+                std::exception_ptr e;
+                std::swap(e, m_error);
+                std::rethrow_exception(e);
+            }
+        }
+    };
+
+    /// Runs f(first, last) for the consecutive chunks of at most grain
+    /// indices from [first, last) and waits for all of them.
+    template <typename F>
+    void parallel_for(std::size_t first, std::size_t last, std::size_t grain, F f)
+    {
+        grain = std::max<std::size_t>(grain, 1);
+        task_group group { *this };
+        while (last - first > grain) {
+            const std::size_t b = first;
+            first += grain;
+            group.run([&f, b, grain] { f(b, b + grain); });
+        }
+        if (first != last) {
+            f(first, last);
+        }
+        group.wait();
+    }
+
+    /// The pool used by the parallel algorithms unless an external one is
+    /// injected.
+    static thread_pool& default_pool()
+    {
+        static thread_pool pool;
+        return pool;
+    }
+
+private:
+    static thread_pool*& injected()
+    {
+        static thread_pool* pool = nullptr;
+        return pool;
+    }
+
+    static thread_pool*& scoped()
+    {
+        static thread_local thread_pool* pool = nullptr;
+        return pool;
+    }
+
+public:
+    /// The pool the parallel algorithms schedule on from the calling
+    /// thread: the pool of the calling worker, the pool of the innermost
+    /// scoped_pool, the pool set by set_default, or the default one.
+    static thread_pool& current()
+    {
+        const thread_pool* self = this_worker().first;
+        if (self) {
+            return const_cast<thread_pool&>(*self);
+        }
+        if (scoped()) {
+            return *scoped();
+        }
+        thread_pool* global = injected();
+        return global ? *global : default_pool();
+    }
+
+    /// Replaces the default pool by an external one for all threads;
+    /// nullptr restores the built-in default. Not to be called while any
+    /// parallel algorithm runs.
+    static void set_default(thread_pool* pool)
+    {
+        injected() = pool;
+    }
+
+    /// Injects an external pool for the parallel algorithms called from the
+    /// current thread during the lifetime of the object.
+    class scoped_pool {
+
+        thread_pool* m_previous;
+
+    public:
+        explicit scoped_pool(thread_pool& pool) : m_previous { scoped() }
+        {
+            scoped() = &pool;
+        }
+
+        ~scoped_pool()
+        {
+            scoped() = m_previous;
+        }
+
+        scoped_pool(const scoped_pool&) = delete;
+        scoped_pool& operator=(const scoped_pool&) = delete;
+    };
+};
+
+#endif
@@ -6,9 +6,11 @@
 #include <deque>
 #include <cassert>
 #include <iterator>
+#include <initializer_list>
 #include <algorithm>
 
 #include "config.h"
+#include "memory.h"
 
 #if 0
 concept Topology : Regular {
@@ -17,9 +19,19 @@ concept Topology : Regular {
     static ForwardIterator<node> out_end(self, node);
     static ForwardIterator<edge> edge_begin(self);
     static ForwardIterator<edge> edge_end(self);
+    static std::size_t version(self);
 }
 #endif
 
+/// True if the topology knows that dst cannot be reached from src without
+/// any search. The topologies keeping a connectivity index, e.g. the
+/// indexed_graph, overload it; the others never know.
+template <class Topology>
+bool known_unreachable(const Topology&, node, node)
+{
+    return false;
+}
+
 #include "topology_graph.h"
 #include "topology_path.h"
 #include "topology_tree.h"
@@ -0,0 +1,295 @@
+#ifndef TOPOLOGY_COMPRESSED_H
+#define TOPOLOGY_COMPRESSED_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+
+#include "config.h"
+#include "memory.h"
+#include "parallel.h"
+
+namespace detail {
+
+    inline void varint_put(std::uint64_t x, std::vector<std::uint8_t>& out)
+    {
+        while (x >= 0x80) {
+            out.push_back(static_cast<std::uint8_t>(x | 0x80));
+            x >>= 7;
+        }
+        out.push_back(static_cast<std::uint8_t>(x));
+    }
+
+    inline std::uint64_t varint_get(const std::uint8_t*& in)
+    {
+        std::uint64_t result = 0;
+        int shift = 0;
+        while (*in & 0x80) {
+            result |= std::uint64_t { *in++ & 0x7fu } << shift;
+            shift += 7;
+        }
+        return result | std::uint64_t { *in++ } << shift;
+    }
+
+    inline void varint_skip(const std::uint8_t*& in, std::uint64_t count)
+    {
+        while (count) {
+            count -= !(*in++ & 0x80);
+        }
+    }
+
+    inline std::uint64_t zigzag_encode(std::int64_t x)
+    {
+        return (static_cast<std::uint64_t>(x) << 1) ^ static_cast<std::uint64_t>(x >> 63);
+    }
+
+    inline std::int64_t zigzag_decode(std::uint64_t x)
+    {
+        return static_cast<std::int64_t>(x >> 1) ^ -static_cast<std::int64_t>(x & 1);
+    }
+
+}
+
+/// Compressed read-only implementation of the topological structure for the
+/// very large sparse graphs. The sorted neighbors of each node are stored as
+/// the variable length encoded gaps: the count of the neighbors, the first
+/// neighbor relative to the node (zigzag encoded, as it may precede the node)
+/// and the differences of the subsequent ones. The lists follow each other
+/// in a single byte array; the position of every block-th list is indexed,
+/// the lists in between are skipped over.
+///
+/// The out_iterator decodes the neighbors on the fly; the out_end of any node
+/// is the same exhausted iterator, so it costs no lookup.
+struct compressed_graph {
+
+    /// The count of the nodes per an indexed position.
+    static const node block = 16;
+
+    node count = 0;
+    std::vector<std::uint8_t> bytes;
+    std::vector<std::size_t> index;
+
+    /// The forward iterator decoding a neighbor list.
+    struct out_iterator : std::iterator<std::forward_iterator_tag, node> {
+
+        const std::uint8_t* in;
+        std::uint64_t remaining;
+        node current;
+
+        out_iterator() : in { nullptr }, remaining { 0 }, current { 0 } {}
+
+        out_iterator(const std::uint8_t* i, node u) : in { i }, remaining { detail::varint_get(in) }, current { u }
+        {
+            if (remaining) {
+                current += detail::zigzag_decode(detail::varint_get(in));
+            }
+        }
+
+        // Regular:
+        friend bool operator==(const out_iterator& x, const out_iterator& y)
+        {
+            return x.remaining == y.remaining;
+        }
+
+        friend bool operator!=(const out_iterator& x, const out_iterator& y)
+        {
+            return !(x == y);
+        }
+
+        // Forward Iterator:
+        out_iterator& operator++()
+        {
+            if (--remaining) {
+                current += detail::varint_get(in);
+            }
+            return *this;
+        }
+
+        const out_iterator operator++(int)
+        {
+            out_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        node operator*() const
+        {
+            return current;
+        }
+    };
+
+    /// The iterator over the edges, node by node.
+    struct const_edge_iterator : std::iterator<std::forward_iterator_tag, edge> {
+
+        const compressed_graph* graph;
+        node nd;
+        out_iterator out;
+
+        const_edge_iterator() : graph { nullptr }, nd { 0 } {}
+
+        const_edge_iterator(const compressed_graph* g, node n, const std::uint8_t* in) : graph { g }, nd { n }
+        {
+            if (nd < graph->count) {
+                out = { in, nd };
+                skip_empty();
+            }
+        }
+
+        void skip_empty()
+        {
+            while (out.remaining == 0 && ++nd < graph->count) {
+                out = { out.in, nd };
+            }
+        }
+
+        friend bool operator==(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return x.nd == y.nd && x.out == y.out;
+        }
+
+        friend bool operator!=(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return !(x == y);
+        }
+
+        const_edge_iterator& operator++()
+        {
+            ++out;
+            skip_empty();
+            return *this;
+        }
+
+        const const_edge_iterator operator++(int)
+        {
+            const_edge_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        edge operator*() const
+        {
+            return { nd, *out };
+        }
+    };
+
+    compressed_graph() = default;
+
+    /// Compresses the given topology of the nodes [0, max_node(t)]; the
+    /// blocks of the nodes are encoded by the workers.
+    ///
+    /// @param t The topology, e.g. a csr_graph,
+    /// @param threads The number of workers, zero for the size of the current thread_pool.
+    template <class Topology>
+    explicit compressed_graph(const Topology& t, unsigned threads = 0)
+    {
+        count = max_node(t) + 1;
+        const std::size_t blocks = (count + block - 1) / block;
+        const unsigned workers = detail::worker_count(threads);
+
+        std::vector<std::vector<std::uint8_t>> encoded(blocks);
+        detail::parallel_blocks(blocks, workers, [&](unsigned, std::size_t b, std::size_t e) {
+            std::vector<node> neighbors;
+            for (std::size_t k = b; k < e; ++k) {
+                const node last = std::min<node>(count, (k + 1) * block);
+                for (node u = k * block; u < last; ++u) {
+                    neighbors.assign(out_begin(t, u), out_end(t, u));
+                    std::sort(begin(neighbors), end(neighbors));
+                    detail::varint_put(neighbors.size(), encoded[k]);
+                    node previous = u;
+                    for (std::size_t i = 0; i < neighbors.size(); ++i) {
+                        if (i == 0) {
+                            detail::varint_put(detail::zigzag_encode(std::int64_t { neighbors[0] } - u), encoded[k]);
+                        } else {
+                            detail::varint_put(neighbors[i] - previous, encoded[k]);
+                        }
+                        previous = neighbors[i];
+                    }
+                }
+            }
+        });
+
+        index.resize(blocks);
+        std::size_t size = 0;
+        for (std::size_t k = 0; k < blocks; ++k) {
+            index[k] = size;
+            size += encoded[k].size();
+        }
+        bytes.resize(size);
+        detail::parallel_blocks(blocks, workers, [&](unsigned, std::size_t b, std::size_t e) {
+            for (std::size_t k = b; k < e; ++k) {
+                std::copy(begin(encoded[k]), end(encoded[k]), begin(bytes) + index[k]);
+                std::vector<std::uint8_t>().swap(encoded[k]);
+            }
+        });
+    }
+
+    // Semiregular: by default
+
+    // Regular:
+    friend bool operator==(const compressed_graph& x, const compressed_graph& y)
+    {
+        return x.count == y.count && x.bytes == y.bytes;
+    }
+
+    friend bool operator!=(const compressed_graph& x, const compressed_graph& y)
+    {
+        return !(x == y);
+    }
+
+    /// The start of the neighbor list of the node.
+    const std::uint8_t* list(node x) const
+    {
+        const std::uint8_t* in = bytes.data() + index[x / block];
+        for (node u = x - x % block; u < x; ++u) {
+            detail::varint_skip(in, detail::varint_get(in));
+        }
+        return in;
+    }
+
+    /// The structure is immutable.
+    friend std::size_t version(const compressed_graph&)
+    {
+        return 0;
+    }
+
+    friend memory_footprint memory_usage(const compressed_graph& g)
+    {
+        return detail::vector_footprint(g.bytes) + detail::vector_footprint(g.index);
+    }
+
+    // Topology operations:
+    friend int nodes_count(const compressed_graph& g)
+    {
+        return g.count;
+    }
+
+    /// The greatest node, known without decoding the edges.
+    friend node max_node(const compressed_graph& g)
+    {
+        return g.count - 1;
+    }
+
+    friend out_iterator out_begin(const compressed_graph& g, node x)
+    {
+        return { g.list(x), x };
+    }
+
+    friend out_iterator out_end(const compressed_graph&, node)
+    {
+        return {};
+    }
+
+    friend const_edge_iterator edge_begin(const compressed_graph& g)
+    {
+        return { &g, 0, g.bytes.data() };
+    }
+
+    friend const_edge_iterator edge_end(const compressed_graph& g)
+    {
+        return { &g, g.count, nullptr };
+    }
+};
+
+#endif
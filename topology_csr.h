@@ -0,0 +1,333 @@
+#ifndef TOPOLOGY_CSR_H
+#define TOPOLOGY_CSR_H
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+#include "config.h"
+#include "weight.h"
+#include "parallel.h"
+#include "memory.h"
+
+/// Compressed sparse row implementation of the topological structure.
+/// The neighbors of all the nodes are stored in a single array, sorted by
+/// the node and then by the neighbor; the node x owns the range
+/// [offsets[x], offsets[x + 1]) of it. The structure is immutable once
+/// built, takes one node per edge plus one offset per node and its edges
+/// are identified by their positions in the array.
+struct csr_graph {
+
+    std::vector<std::size_t> offsets;
+    std::vector<node> targets;
+
+    /// The random access iterator over the edges.
+    struct const_edge_iterator : std::iterator<std::random_access_iterator_tag, edge> {
+
+        const csr_graph *graph;
+        node nd;
+        std::size_t index;
+
+        const_edge_iterator(const csr_graph *g, node n, std::size_t i) : graph { g }, nd { n }, index { i } {}
+
+        // Semiregular:
+        const_edge_iterator() : graph { nullptr }, nd { 0 }, index { 0 } {}
+
+        // Regular:
+        friend bool operator==(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return x.index == y.index;
+        }
+
+        friend bool operator!=(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return !(x == y);
+        }
+
+        // Forward Iterator:
+        const_edge_iterator& operator++()
+        {
+            ++index;
+            while (nd + 1 < static_cast<node>(graph->offsets.size()) && graph->offsets[nd + 1] <= index) {
+                ++nd;
+            }
+            return *this;
+        }
+
+        const const_edge_iterator operator++(int)
+        {
+            const_edge_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        edge operator*() const
+        {
+            return { nd, graph->targets[index] };
+        }
+
+        // Bidirectional and random access iterator:
+        const_edge_iterator& operator+=(std::ptrdiff_t n)
+        {
+            index += n;
+            nd = graph->source(index);
+            return *this;
+        }
+
+        const_edge_iterator& operator-=(std::ptrdiff_t n) { return *this += -n; }
+        const_edge_iterator& operator--() { return *this -= 1; }
+
+        const const_edge_iterator operator--(int)
+        {
+            const_edge_iterator copy = *this;
+            --(*this);
+            return copy;
+        }
+
+        friend const_edge_iterator operator+(const_edge_iterator x, std::ptrdiff_t n) { return x += n; }
+        friend const_edge_iterator operator+(std::ptrdiff_t n, const_edge_iterator x) { return x += n; }
+        friend const_edge_iterator operator-(const_edge_iterator x, std::ptrdiff_t n) { return x -= n; }
+
+        friend std::ptrdiff_t operator-(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return static_cast<std::ptrdiff_t>(x.index) - static_cast<std::ptrdiff_t>(y.index);
+        }
+
+        edge operator[](std::ptrdiff_t n) const { return *(*this + n); }
+
+        friend bool operator<(const const_edge_iterator& x, const const_edge_iterator& y) { return x.index < y.index; }
+        friend bool operator>(const const_edge_iterator& x, const const_edge_iterator& y) { return y < x; }
+        friend bool operator<=(const const_edge_iterator& x, const const_edge_iterator& y) { return !(y < x); }
+        friend bool operator>=(const const_edge_iterator& x, const const_edge_iterator& y) { return !(x < y); }
+    };
+
+    csr_graph() : offsets { 0 } {}
+
+    /// Builds the graph of the nodes [0, node_count) from the given unique
+    /// edges; with symmetric set both directions of every edge are added.
+    /// The edges are distributed over the workers, each row is then sorted.
+    ///
+    /// @param node_count The number of the nodes,
+    /// @param edges The edges; no edge may be repeated,
+    /// @param symmetric True if the reversed edges are to be added as well,
+    /// @param threads The number of workers, zero for the size of the current thread_pool.
+    csr_graph(node node_count, const std::vector<edge>& edges, bool symmetric = false, unsigned threads = 0)
+    {
+        const unsigned workers = detail::worker_count(threads);
+        const std::size_t M = edges.size();
+
+        std::vector<std::atomic<std::size_t>> cursor(node_count + 1);
+        detail::parallel_blocks(M, workers, [&](unsigned, std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i) {
+                cursor[edges[i].first].fetch_add(1, std::memory_order_relaxed);
+                if (symmetric) {
+                    cursor[edges[i].second].fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        offsets.assign(node_count + 1, 0);
+        for (node u = 0; u < node_count; ++u) {
+            offsets[u + 1] = offsets[u] + cursor[u].load(std::memory_order_relaxed);
+            cursor[u].store(offsets[u], std::memory_order_relaxed);
+        }
+
+        targets.resize(offsets.back());
+        detail::parallel_blocks(M, workers, [&](unsigned, std::size_t b, std::size_t e) {
+            for (std::size_t i = b; i < e; ++i) {
+                const edge& uv = edges[i];
+                targets[cursor[uv.first].fetch_add(1, std::memory_order_relaxed)] = uv.second;
+                if (symmetric) {
+                    targets[cursor[uv.second].fetch_add(1, std::memory_order_relaxed)] = uv.first;
+                }
+            }
+        });
+
+        detail::parallel_blocks(node_count, workers, [&](unsigned, std::size_t b, std::size_t e) {
+            for (std::size_t u = b; u < e; ++u) {
+                std::sort(targets.begin() + offsets[u], targets.begin() + offsets[u + 1]);
+            }
+        });
+    }
+
+    // Semiregular: by default
+
+    // Regular:
+    friend bool operator==(const csr_graph& x, const csr_graph& y)
+    {
+        return x.offsets == y.offsets && x.targets == y.targets;
+    }
+
+    friend bool operator!=(const csr_graph& x, const csr_graph& y)
+    {
+        return !(x == y);
+    }
+
+    /// The position of the edge (u, v) in the targets or the count of the
+    /// edges if there is no such edge.
+    std::size_t edge_index(node u, node v) const
+    {
+        if (u < 0 || u + 1 >= static_cast<node>(offsets.size())) {
+            return targets.size();
+        }
+        const auto first = targets.begin() + offsets[u];
+        const auto last = targets.begin() + offsets[u + 1];
+        const auto found = std::lower_bound(first, last, v);
+        return found != last && *found == v ? found - targets.begin() : targets.size();
+    }
+
+    /// The node owning the given position of the targets.
+    node source(std::size_t index) const
+    {
+        return std::upper_bound(offsets.begin(), offsets.end(), index) - offsets.begin() - 1;
+    }
+
+    std::size_t edges_count() const
+    {
+        return targets.size();
+    }
+
+    /// The structure is immutable.
+    friend std::size_t version(const csr_graph&)
+    {
+        return 0;
+    }
+
+    friend memory_footprint memory_usage(const csr_graph& g)
+    {
+        return detail::vector_footprint(g.offsets) + detail::vector_footprint(g.targets);
+    }
+
+    // Topology operations:
+    friend int nodes_count(const csr_graph& g)
+    {
+        return g.offsets.size() - 1;
+    }
+
+    /// The greatest node; unlike for the general topologies it is known
+    /// without scanning the edges.
+    friend node max_node(const csr_graph& g)
+    {
+        return g.offsets.size() - 2;
+    }
+
+    friend const node* out_begin(const csr_graph& g, node x)
+    {
+        return g.targets.data() + g.offsets[x];
+    }
+
+    friend const node* out_end(const csr_graph& g, node x)
+    {
+        return g.targets.data() + g.offsets[x + 1];
+    }
+
+    friend const_edge_iterator edge_begin(const csr_graph& g)
+    {
+        return { &g, g.source(0), 0 };
+    }
+
+    friend const_edge_iterator edge_end(const csr_graph& g)
+    {
+        return { &g, static_cast<node>(g.offsets.size() - 1), g.targets.size() };
+    }
+};
+
+/// The metric of the edges of a csr_graph, stored in an array parallel to
+/// the graph's targets. A symmetric metric has to store the same weight for
+/// both directions of an edge.
+///
+/// The metric refers to the graph to look the edges up: the graph must
+/// outlive the metric and must neither be moved nor modified meanwhile; the
+/// copies of the metric refer to the same graph.
+///
+/// @tparam W A Weight.
+template <Weight W>
+class csr_metric {
+
+    const csr_graph* m_graph = nullptr;
+    std::vector<W> m_weights;
+    std::size_t m_version = 0;
+
+    /// @throws std::out_of_range if the edge is not in the graph.
+    std::size_t index(const edge& e) const
+    {
+        const std::size_t i = m_graph->edge_index(e.first, e.second);
+        if (i == m_weights.size()) {
+            throw std::out_of_range("csr_metric: no such edge");
+        }
+        return i;
+    }
+
+public:
+    typedef W weight_type;
+
+    csr_metric() = default;
+
+    explicit csr_metric(const csr_graph& g, const W& init = weight_traits<W>::zero()) :
+        m_graph { &g },
+        m_weights(g.edges_count(), init)
+    {}
+
+    // Regular:
+    friend bool operator==(const csr_metric& x, const csr_metric& y)
+    {
+        return x.m_weights == y.m_weights;
+    }
+
+    friend bool operator!=(const csr_metric& x, const csr_metric& y) { return !(x == y); }
+
+    friend std::size_t version(const csr_metric& x) { return x.m_version; }
+
+    friend memory_footprint memory_usage(const csr_metric& x) { return detail::vector_footprint(x.m_weights); }
+
+    // Metric operations:
+
+    /// @throws std::out_of_range if the edge is not in the graph.
+    const weight_type& operator()(const edge& e) const
+    {
+        return m_weights[index(e)];
+    }
+
+    /// The writable access; any use of it counts as a modification.
+    /// @throws std::out_of_range if the edge is not in the graph.
+    weight_type& operator()(const edge& e)
+    {
+        const std::size_t i = index(e);
+        ++m_version;
+        return m_weights[i];
+    }
+
+    /// Sets the weight of every edge (u, v) to f(u, v); the rows are
+    /// distributed over the workers.
+    template <typename F>
+    void assign(F f, unsigned threads = 0)
+    {
+        ++m_version;
+        const csr_graph& g = *m_graph;
+        detail::parallel_blocks(nodes_count(g), detail::worker_count(threads),
+            [this, &g, &f](unsigned, std::size_t b, std::size_t e) {
+                for (std::size_t u = b; u < e; ++u) {
+                    for (std::size_t i = g.offsets[u]; i < g.offsets[u + 1]; ++i) {
+                        m_weights[i] = f(static_cast<node>(u), g.targets[i]);
+                    }
+                }
+            });
+    }
+
+    /// The weight of the edge at the given position of the graph's targets.
+    const weight_type& at(std::size_t index) const
+    {
+        return m_weights[index];
+    }
+
+    weight_type& at(std::size_t index)
+    {
+        ++m_version;
+        return m_weights[index];
+    }
+};
+
+#endif
@@ -1,6 +1,11 @@
 #ifndef TOPOLOGY_GRAPH_H
 #define TOPOLOGY_GRAPH_H
 
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+
 #if 0
 concept Graph : Topology {
     void set(edge);
@@ -15,6 +20,7 @@ concept Graph : Topology {
 struct adj_list {
 
     std::vector<std::vector<node>> adjacency;
+    std::size_t m_version = 0;
 
     /// The object enabling iteraton over the topological structure edges.
     /// This type is needed here, because the adjacency list is defined
@@ -74,6 +80,14 @@ struct adj_list {
     };
 
     // Semiregular: by default
+    adj_list() = default;
+
+    // Custom constructor:
+    template <typename EdgeIt>
+    adj_list(EdgeIt first, EdgeIt last, bool dedup = false)
+    {
+        assign(first, last, dedup);
+    }
 
     // Regular:
     friend bool operator==(const adj_list& x, const adj_list& y)
@@ -89,14 +103,84 @@ struct adj_list {
     // Graph operations:
     void set(const edge& e)
     {
+        ++m_version;
         node from = e.first;
         node to = e.second;
-        if (from >= static_cast<node>(adjacency.size())) {
-            adjacency.resize(from + 1);
+        node max_index = std::max(from, to);
+        if (max_index >= static_cast<node>(adjacency.size())) {
+            adjacency.resize(max_index + 1);
         }
         adjacency[from].push_back(to);
     }
 
+    /// Replaces the structure with the given edges in a single pass: the
+    /// out-degrees are counted first, so that every neighbor list is
+    /// allocated once. The neighbors keep the order of the edges, unless the
+    /// parallel edges are removed, which sorts them.
+    ///
+    /// @tparam EdgeIt A ForwardIterator over the edges,
+    ///
+    /// @param first The first edge,
+    /// @param last The end of the edges,
+    /// @param dedup True if the repeated edges are to be stored once.
+    template <typename EdgeIt>
+    void assign(EdgeIt first, EdgeIt last, bool dedup = false)
+    {
+        ++m_version;
+
+        std::vector<std::size_t> degrees;
+        for (EdgeIt it = first; it != last; ++it) {
+            const edge e = *it;
+            const std::size_t max_index = std::max(e.first, e.second);
+            if (max_index >= degrees.size()) {
+                degrees.resize(max_index + 1, 0);
+            }
+            ++degrees[e.first];
+        }
+
+        adjacency.clear();
+        adjacency.resize(degrees.size());
+        for (std::size_t u = 0; u < degrees.size(); ++u) {
+            adjacency[u].reserve(degrees[u]);
+        }
+        for (EdgeIt it = first; it != last; ++it) {
+            const edge e = *it;
+            adjacency[e.first].push_back(e.second);
+        }
+
+        if (dedup) {
+            for (auto& neighbors : adjacency) {
+                std::sort(begin(neighbors), end(neighbors));
+                neighbors.erase(std::unique(begin(neighbors), end(neighbors)), end(neighbors));
+            }
+        }
+    }
+
+    /// Reserves the room for the nodes [0, count) without adding any, as
+    /// std::vector::reserve does.
+    void reserve(node count)
+    {
+        adjacency.reserve(count);
+    }
+
+    /// The modification counter, bumped by every set().
+    friend std::size_t version(const adj_list& g)
+    {
+        return g.m_version;
+    }
+
+    /// The owned memory; the headers of the neighbor vectors are overhead.
+    friend memory_footprint memory_usage(const adj_list& g)
+    {
+        memory_footprint result = detail::vector_footprint(g.adjacency);
+        result.overhead += result.payload;
+        result.payload = 0;
+        for (const auto& neighbors : g.adjacency) {
+            result += detail::vector_footprint(neighbors);
+        }
+        return result;
+    }
+
     // Topology operations:
     friend int nodes_count(const adj_list& g)
     {
@@ -126,7 +210,14 @@ struct adj_list {
 
     friend const_edge_iterator edge_begin(const adj_list& g)
     {
-        return { &g, 0, 0 };
+        const_edge_iterator result { &g, 0, 0 };
+
+        if (!g.adjacency.empty() && g.adjacency[0].empty()) {
+            result.adj = -1;
+            ++result;
+        }
+
+        return result;
     }
 
     friend const_edge_iterator edge_end(const adj_list& g)
@@ -144,6 +235,8 @@ struct adj_matrix {
 
     std::vector<bool> matrix;
     int nodes;
+    int stride;
+    std::size_t m_version = 0;
 
     /// The iterator enabling iteration over the set of neighbors of the given
     /// node. In the case of the adjacency matrix this type of iterator needs
@@ -239,7 +332,7 @@ struct adj_matrix {
                     }
                     v = 0;
                 }
-            } while (!graph->matrix.at(N * u + v));
+            } while (!graph->has(u, v));
 
             return *this;
         }
@@ -258,26 +351,54 @@ struct adj_matrix {
     };
 
     // Semiregular:
-    adj_matrix() : nodes{ 0 } {}
+    adj_matrix() : nodes{ 0 }, stride{ 0 } {}
     ~adj_matrix() = default;
     adj_matrix(const adj_matrix& x) = default;
     adj_matrix(adj_matrix&& x) = default;
     adj_matrix& operator=(const adj_matrix& x) = default;
     adj_matrix& operator=(adj_matrix&& x) = default;
 
-    // Custom constructor:
-    template <typename I>
+    // Custom constructors:
+
+    /// The structure from the rows of the square boolean matrix.
+    template <typename I, typename std::enable_if<
+        !std::is_convertible<typename std::iterator_traits<I>::value_type, edge>::value, int>::type = 0>
     adj_matrix(I first, I last) : matrix{ first, last }
     {
         double nodes_dbl = sqrt(matrix.size());
         assert((nodes_dbl - (double)(int)nodes_dbl) == 0.0);
         nodes = static_cast<int>(nodes_dbl);
+        stride = nodes;
+    }
+
+    /// The structure of the given edges.
+    template <typename EdgeIt, typename std::enable_if<
+        std::is_convertible<typename std::iterator_traits<EdgeIt>::value_type, edge>::value, long>::type = 0>
+    adj_matrix(EdgeIt first, EdgeIt last) : adj_matrix {}
+    {
+        assign(first, last);
     }
 
+    /// The structure of the nodes [0, count) without any edges.
+    explicit adj_matrix(node count) : matrix(std::size_t(count) * count, false), nodes{ count }, stride{ count } {}
+
     // Regular:
     friend bool operator==(const adj_matrix& x, const adj_matrix& y)
     {
-        return x.nodes == y.nodes && x.matrix == y.matrix;
+        if (x.nodes != y.nodes) {
+            return false;
+        }
+        if (x.stride == y.stride) {
+            return x.matrix == y.matrix;
+        }
+        for (node u = 0; u < x.nodes; ++u) {
+            for (node v = 0; v < x.nodes; ++v) {
+                if (x.has(u, v) != y.has(u, v)) {
+                    return false;
+                }
+            }
+        }
+        return true;
     }
 
     friend bool operator!=(const adj_matrix& x, const adj_matrix& y)
@@ -285,33 +406,91 @@ struct adj_matrix {
         return !(x == y);
     }
 
+    /// True if the edge (u, v) is set.
+    bool has(node u, node v) const
+    {
+        return matrix[std::size_t(stride) * u + v];
+    }
+
     // Graph operations:
+
+    /// Sets the edge; the rows are allocated for at least twice as many
+    /// nodes as before whenever the edge exceeds them, so that the nodes
+    /// added one by one cost an amortized constant time each.
     void set(const edge& e)
     {
-        node from = e.first;
-        node to = e.second;
-        node max_index = std::max(from, to);
+        ++m_version;
 
-        if (static_cast<node>(matrix.size()) > (max_index * max_index)) {
-            matrix[nodes * from + to] = true;
-            return;
+        node max_index = std::max(e.first, e.second);
+        if (max_index >= stride) {
+            grow(std::max(max_index + 1, 2 * stride));
         }
+        nodes = std::max(nodes, max_index + 1);
+        matrix[std::size_t(stride) * e.first + e.second] = true;
+    }
 
-        int new_nodes = max_index + 1;
-        std::vector<bool> new_matrix(new_nodes * new_nodes, false);
+    /// Replaces the structure with the given edges, allocated at once for
+    /// the greatest node of them; the repeated edges are set once.
+    ///
+    /// @tparam EdgeIt A ForwardIterator over the edges.
+    template <typename EdgeIt>
+    void assign(EdgeIt first, EdgeIt last)
+    {
+        ++m_version;
 
-        for (int f = 0; f < nodes; ++f) {
-            for (int t = 0; t < nodes; ++t) {
-                new_matrix[new_nodes * f + t] = matrix[nodes * f + t];
-            }
+        node max_index = -1;
+        for (EdgeIt it = first; it != last; ++it) {
+            const edge e = *it;
+            max_index = std::max(max_index, std::max(e.first, e.second));
+        }
+
+        nodes = stride = max_index + 1;
+        matrix.assign(std::size_t(stride) * stride, false);
+        for (EdgeIt it = first; it != last; ++it) {
+            const edge e = *it;
+            matrix[std::size_t(stride) * e.first + e.second] = true;
+        }
+    }
+
+    /// Presizes the rows for the nodes [0, count).
+    void reserve(node count)
+    {
+        if (count > stride) {
+            grow(count);
         }
+    }
+
+private:
+    void grow(node new_stride)
+    {
+        std::vector<bool> new_matrix(std::size_t(new_stride) * new_stride, false);
 
-        new_matrix[new_nodes * from + to] = true;
+        for (int f = 0; f < nodes; ++f) {
+            auto row = begin(matrix) + std::size_t(stride) * f;
+            std::copy(row, row + nodes, begin(new_matrix) + std::size_t(new_stride) * f);
+        }
 
-        nodes = new_nodes;
+        stride = new_stride;
         matrix = std::move(new_matrix);
     }
 
+public:
+    /// The modification counter, bumped by every set().
+    friend std::size_t version(const adj_matrix& g)
+    {
+        return g.m_version;
+    }
+
+    /// The owned memory; the rows allocated beyond the nodes are slack.
+    friend memory_footprint memory_usage(const adj_matrix& g)
+    {
+        memory_footprint result = detail::vector_footprint(g.matrix);
+        const std::size_t payload = (std::size_t(g.nodes) * g.nodes + 7) / 8;
+        result.slack += result.payload - payload;
+        result.payload = payload;
+        return result;
+    }
+
     // Topology operations:
     friend int nodes_count(const adj_matrix& g)
     {
@@ -320,7 +499,7 @@ struct adj_matrix {
 
     friend out_iterator out_begin(const adj_matrix& g, node u)
     {
-        auto first = begin(g.matrix) + u * g.nodes;
+        auto first = begin(g.matrix) + std::size_t(g.stride) * u;
         auto last = first + g.nodes;
         out_iterator result { first, last };
 
@@ -332,15 +511,19 @@ struct adj_matrix {
 
     friend out_iterator out_end(const adj_matrix& g, node u)
     {
-        auto last = begin(g.matrix) + u * g.nodes + g.nodes;
+        auto last = begin(g.matrix) + std::size_t(g.stride) * u + g.nodes;
         return out_iterator { last, last };
     }
 
     friend const_edge_iterator edge_begin(const adj_matrix& g)
     {
+        if (g.nodes == 0) {
+            return edge_end(g);
+        }
+
         const_edge_iterator result { &g, 0, 0 };
 
-        if (!g.matrix.at(0)) {
+        if (!g.has(0, 0)) {
             ++result;
         }
 
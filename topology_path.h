@@ -142,6 +142,11 @@ struct const_path_edge_iterator : std::iterator<std::forward_iterator_tag, edge>
     }
 };
 
+inline memory_footprint memory_usage(const path& p)
+{
+    return detail::deque_footprint(p);
+}
+
 // Topology operations:
 inline int nodes_count(const path &p)
 {
@@ -12,6 +12,7 @@ concept Tree : Topology {
 struct tree {
 
     std::multimap<node, node> m_impl;
+    std::size_t m_version = 0;
 
     /// The iterator enabling visiting all the neighbors of the given node.
     struct out_iterator : std::iterator<std::forward_iterator_tag, node> {
@@ -140,6 +141,16 @@ struct tree {
     };
 
     // Semiregular: by default
+    tree() = default;
+
+    // Custom constructors:
+    tree(std::initializer_list<edge> edges) : m_impl(edges.begin(), edges.end()) {}
+
+    template <typename EdgeIt>
+    tree(EdgeIt first, EdgeIt last)
+    {
+        assign(first, last);
+    }
 
     // Regular:
     friend bool operator==(const tree& x, const tree& y)
@@ -155,9 +166,31 @@ struct tree {
     // Tree operations:
     void set(const edge& e)
     {
+        ++m_version;
         m_impl.insert(e);
     }
 
+    /// Replaces the structure with the given edges. The edges sorted by the
+    /// parent, as enumerated by edge_begin(), are inserted in a linear time.
+    template <typename EdgeIt>
+    void assign(EdgeIt first, EdgeIt last)
+    {
+        ++m_version;
+        m_impl.clear();
+        m_impl.insert(first, last);
+    }
+
+    /// The modification counter, bumped by every set().
+    friend std::size_t version(const tree& t)
+    {
+        return t.m_version;
+    }
+
+    friend memory_footprint memory_usage(const tree& t)
+    {
+        return detail::map_footprint(t.m_impl);
+    }
+
     // Topology operations:
     friend int nodes_count(const tree& t)
     {
@@ -0,0 +1,270 @@
+#ifndef TOPOLOGY_VIEW_H
+#define TOPOLOGY_VIEW_H
+
+#include <vector>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include "config.h"
+#include "memory.h"
+#include "topology.h"
+
+namespace detail {
+
+    /// The edge predicate of a view keeping all the edges.
+    struct keep_edges {
+        bool operator()(const edge&) const
+        {
+            return true;
+        }
+    };
+
+}
+
+/// The read-only view of a topology without some of its nodes and edges,
+/// e.g. for the searches of the what-if scenarios: the graph without the
+/// failed links or nodes, or only with the edges of a low enough delay.
+///
+/// The view excludes the nodes marked in a node mask, the directed edges
+/// listed in an edge mask and the edges rejected by a predicate; an edge is
+/// excluded together with either of its nodes. Nothing of the topology is
+/// copied: the node mask is referenced, so that it may be reused for many
+/// views, and only the edge mask is owned, sorted for the lookups. Creating
+/// a view thus costs O(k log k) for k masked edges.
+///
+/// The view refers to the topology and the node mask, which must outlive it
+/// and stay unchanged while it is iterated. The nodes keep their numbers;
+/// the masked nodes only lose all their edges.
+///
+/// @tparam Topology The underlying topology,
+/// @tparam EdgePred The functor returning true for the edges kept.
+template <class Topology, typename EdgePred = detail::keep_edges>
+class topology_view {
+
+    using impl_out_iterator = decltype(out_begin(std::declval<const Topology&>(), node {}));
+    using impl_edge_iterator = decltype(edge_begin(std::declval<const Topology&>()));
+
+    const Topology* m_topology;
+    const std::vector<char>* m_removed_nodes;
+    std::vector<edge> m_removed_edges;
+    EdgePred m_pred;
+
+public:
+    /// The view of the topology with the edges rejected by the predicate.
+    explicit topology_view(const Topology& t, EdgePred pred = EdgePred {}) :
+        m_topology { &t }, m_removed_nodes { nullptr }, m_pred(std::move(pred))
+    {}
+
+    /// The view of the topology without the masked nodes and edges.
+    ///
+    /// @param t The topology,
+    /// @param removed_nodes The mask of the nodes excluded, indexed by the
+    ///                      nodes, at least up to max_node(t); referenced,
+    /// @param removed_edges The directed edges excluded; the undirected
+    ///                      links are to be listed in both directions,
+    /// @param pred The predicate of the edges kept.
+    topology_view(
+            const Topology& t,
+            const std::vector<char>* removed_nodes,
+            std::vector<edge> removed_edges = {},
+            EdgePred pred = EdgePred {}) :
+        m_topology { &t },
+        m_removed_nodes { removed_nodes },
+        m_removed_edges(std::move(removed_edges)),
+        m_pred(std::move(pred))
+    {
+        std::sort(begin(m_removed_edges), end(m_removed_edges));
+    }
+
+    const Topology& topology() const
+    {
+        return *m_topology;
+    }
+
+    bool removed(node x) const
+    {
+        return m_removed_nodes && (*m_removed_nodes)[x];
+    }
+
+    /// True if the edge is excluded, itself or by its nodes.
+    bool excluded(const edge& e) const
+    {
+        if (removed(e.first) || removed(e.second)) {
+            return true;
+        }
+        if (!m_removed_edges.empty() && std::binary_search(begin(m_removed_edges), end(m_removed_edges), e)) {
+            return true;
+        }
+        return !m_pred(e);
+    }
+
+    /// The neighbors' iterator skipping the excluded edges.
+    struct out_iterator : std::iterator<std::forward_iterator_tag, node> {
+
+        const topology_view* view;
+        node u;
+        impl_out_iterator current, last;
+
+        out_iterator() = default;
+
+        out_iterator(const topology_view* view, node u, impl_out_iterator current, impl_out_iterator last) :
+            view { view }, u { u }, current { current }, last { last }
+        {
+            skip();
+        }
+
+        void skip()
+        {
+            while (current != last && view->excluded(edge(u, *current))) {
+                ++current;
+            }
+        }
+
+        friend bool operator==(const out_iterator& x, const out_iterator& y)
+        {
+            return x.current == y.current;
+        }
+
+        friend bool operator!=(const out_iterator& x, const out_iterator& y)
+        {
+            return !(x == y);
+        }
+
+        out_iterator& operator++()
+        {
+            ++current;
+            skip();
+            return *this;
+        }
+
+        const out_iterator operator++(int)
+        {
+            out_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        node operator*() const
+        {
+            return *current;
+        }
+    };
+
+    /// The edges' iterator skipping the excluded edges.
+    struct const_edge_iterator : std::iterator<std::forward_iterator_tag, edge> {
+
+        const topology_view* view;
+        impl_edge_iterator current, last;
+
+        const_edge_iterator() = default;
+
+        const_edge_iterator(const topology_view* view, impl_edge_iterator current, impl_edge_iterator last) :
+            view { view }, current { current }, last { last }
+        {
+            skip();
+        }
+
+        void skip()
+        {
+            while (current != last && view->excluded(*current)) {
+                ++current;
+            }
+        }
+
+        friend bool operator==(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return x.current == y.current;
+        }
+
+        friend bool operator!=(const const_edge_iterator& x, const const_edge_iterator& y)
+        {
+            return !(x == y);
+        }
+
+        const_edge_iterator& operator++()
+        {
+            ++current;
+            skip();
+            return *this;
+        }
+
+        const const_edge_iterator operator++(int)
+        {
+            const_edge_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        edge operator*() const
+        {
+            return *current;
+        }
+    };
+
+    /// The view follows the modifications of the topology.
+    friend std::size_t version(const topology_view& v)
+    {
+        return version(*v.m_topology);
+    }
+
+    /// Only the edge mask is owned.
+    friend memory_footprint memory_usage(const topology_view& v)
+    {
+        return detail::vector_footprint(v.m_removed_edges);
+    }
+
+    // Topology operations:
+
+    /// The nodes of the topology, the masked ones included.
+    friend int nodes_count(const topology_view& v)
+    {
+        return nodes_count(*v.m_topology);
+    }
+
+    /// The greatest node of the topology, so that the workspaces sized for
+    /// the topology serve its views.
+    friend node max_node(const topology_view& v)
+    {
+        return max_node(*v.m_topology);
+    }
+
+    /// The nodes unreachable in the topology stay unreachable in the view,
+    /// as do the masked ones.
+    friend bool known_unreachable(const topology_view& v, node src, node dst)
+    {
+        return src != dst && (v.removed(src) || v.removed(dst) || known_unreachable(*v.m_topology, src, dst));
+    }
+
+    friend out_iterator out_begin(const topology_view& v, node u)
+    {
+        const auto last = out_end(*v.m_topology, u);
+        return { &v, u, v.removed(u) ? last : out_begin(*v.m_topology, u), last };
+    }
+
+    friend out_iterator out_end(const topology_view& v, node u)
+    {
+        const auto last = out_end(*v.m_topology, u);
+        return { &v, u, last, last };
+    }
+
+    friend const_edge_iterator edge_begin(const topology_view& v)
+    {
+        return { &v, edge_begin(*v.m_topology), edge_end(*v.m_topology) };
+    }
+
+    friend const_edge_iterator edge_end(const topology_view& v)
+    {
+        return { &v, edge_end(*v.m_topology), edge_end(*v.m_topology) };
+    }
+};
+
+/// The view of the topology with only the edges accepted by the predicate,
+/// e.g. the edges of a delay below a bound.
+template <class Topology, typename EdgePred>
+topology_view<Topology, EdgePred> filter_edges(const Topology& t, EdgePred pred)
+{
+    return topology_view<Topology, EdgePred> { t, std::move(pred) };
+}
+
+#endif
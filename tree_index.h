@@ -0,0 +1,236 @@
+#ifndef TREE_INDEX_H
+#define TREE_INDEX_H
+
+#include <vector>
+#include <utility>
+
+#include "config.h"
+#include "weight.h"
+#include "memory.h"
+#include "topology.h"
+
+// The index of the paths within a tree.
+// =====================================
+
+namespace detail {
+
+    inline int floor_log2(std::size_t x)
+    {
+        int result = 0;
+        while (x >>= 1) {
+            ++result;
+        }
+        return result;
+    }
+
+}
+
+/// The index answering the queries about the paths between the nodes of a
+/// tree, e.g. of a multicast tree produced by mlra or prim. The tree is
+/// expected to be oriented from its root, as the algorithms build it; a
+/// forest is indexed tree by tree.
+///
+/// The lowest common ancestor is found in a constant time as the shallowest
+/// node between the first visits of the nodes in the Euler tour, by a sparse
+/// table of the tour. The weight between two nodes is taken from the prefix
+/// weights of the nodes, i.e. their distances from the root, hence it
+/// requires the weight to support the subtraction. A path is extracted in
+/// the time proportional to its length.
+///
+/// The index is a snapshot; it is not updated with the tree or the metric.
+///
+/// @tparam W A Weight with the subtraction.
+template <Weight W>
+class tree_index {
+
+    std::vector<node> m_parent;
+    std::vector<node> m_root;
+    std::vector<int> m_depth;
+    std::vector<W> m_prefix;
+    std::vector<int> m_first;
+    std::vector<std::vector<node>> m_table; // m_table[0] is the tour itself
+
+    node shallower(node x, node y) const
+    {
+        return m_depth[y] < m_depth[x] ? y : x;
+    }
+
+public:
+    typedef W weight_type;
+
+    tree_index() = default;
+
+    /// Indexes the given tree weighted by the given metric.
+    ///
+    /// @tparam Metric A metric of the weight W,
+    ///
+    /// @param t The tree oriented from its root(s),
+    /// @param m The metric.
+    template <class Metric>
+    tree_index(const tree& t, const Metric& m)
+    {
+        node N = 0;
+        for (const auto& e : t.m_impl) {
+            N = std::max(N, std::max(e.first, e.second) + 1);
+        }
+
+        m_parent.assign(N, -1);
+        m_root.assign(N, -1);
+        m_depth.assign(N, 0);
+        m_prefix.assign(N, weight_traits<W>::zero());
+        m_first.assign(N, -1);
+
+        // The children in the compressed rows, the multimap keeps them
+        // grouped by the parent.
+        std::vector<int> offsets(N + 1, 0);
+        std::vector<node> children;
+        std::vector<bool> present(N, false);
+        children.reserve(t.m_impl.size());
+        for (const auto& e : t.m_impl) {
+            ++offsets[e.first + 1];
+            children.push_back(e.second);
+            m_parent[e.second] = e.first;
+            present[e.first] = present[e.second] = true;
+        }
+        for (node x = 0; x < N; ++x) {
+            offsets[x + 1] += offsets[x];
+        }
+
+        // The iterative depth first traversal of every tree of the forest.
+        std::vector<node> euler;
+        euler.reserve(2 * N);
+        std::vector<std::pair<node, int>> stack;
+        for (node r = 0; r < N; ++r) {
+            if (!present[r] || m_parent[r] != -1) {
+                continue;
+            }
+            m_root[r] = r;
+            m_first[r] = euler.size();
+            euler.push_back(r);
+            stack.emplace_back(r, offsets[r]);
+            while (!stack.empty()) {
+                const node u = stack.back().first;
+                int& next = stack.back().second;
+                if (next == offsets[u + 1]) {
+                    stack.pop_back();
+                    if (!stack.empty()) {
+                        euler.push_back(stack.back().first);
+                    }
+                    continue;
+                }
+                const node v = children[next++];
+                m_root[v] = r;
+                m_depth[v] = m_depth[u] + 1;
+                m_prefix[v] = m_prefix[u] + m(edge(u, v));
+                m_first[v] = euler.size();
+                euler.push_back(v);
+                stack.emplace_back(v, offsets[v]);
+            }
+        }
+
+        // The sparse table of the shallowest nodes of the power of two
+        // long ranges of the tour.
+        const std::size_t E = euler.size();
+        m_table.clear();
+        m_table.push_back(std::move(euler));
+        for (int k = 1; (std::size_t { 1 } << k) <= E; ++k) {
+            const std::vector<node>& prev = m_table.back();
+            const std::size_t half = std::size_t { 1 } << (k - 1);
+            std::vector<node> level(E - (std::size_t { 1 } << k) + 1);
+            for (std::size_t i = 0; i < level.size(); ++i) {
+                level[i] = shallower(prev[i], prev[i + half]);
+            }
+            m_table.push_back(std::move(level));
+        }
+    }
+
+    /// True if the node belongs to the indexed tree.
+    bool contains(node x) const
+    {
+        return x >= 0 && x < static_cast<node>(m_first.size()) && m_first[x] != -1;
+    }
+
+    /// True if both nodes belong to the same tree of the forest.
+    bool connected(node u, node v) const
+    {
+        return contains(u) && contains(v) && m_root[u] == m_root[v];
+    }
+
+    node root(node x) const { return m_root[x]; }
+    node parent(node x) const { return m_parent[x]; }
+    int depth(node x) const { return m_depth[x]; }
+
+    /// The weight of the path from the root to the node.
+    const W& prefix(node x) const { return m_prefix[x]; }
+
+    /// The lowest common ancestor of the nodes, or -1 if they are not
+    /// connected.
+    node lca(node u, node v) const
+    {
+        if (!connected(u, v)) {
+            return -1;
+        }
+        std::size_t first = m_first[u], last = m_first[v];
+        if (first > last) {
+            std::swap(first, last);
+        }
+        const int k = detail::floor_log2(last - first + 1);
+        return shallower(m_table[k][first], m_table[k][last - (std::size_t { 1 } << k) + 1]);
+    }
+
+    /// The accumulated weight of the path between the nodes, or the infinite
+    /// weight if they are not connected.
+    W distance(node u, node v) const
+    {
+        const node a = lca(u, v);
+        if (a == -1) {
+            return weight_traits<W>::inf();
+        }
+        return (m_prefix[u] - m_prefix[a]) + (m_prefix[v] - m_prefix[a]);
+    }
+
+    /// Stores the path from u to v in out_path, which is left empty if the
+    /// nodes are not connected.
+    void route(node u, node v, path& out_path) const
+    {
+        out_path.clear();
+        const node a = lca(u, v);
+        if (a == -1) {
+            return;
+        }
+        for (node x = u; x != a; x = m_parent[x]) {
+            out_path.push_back(x);
+        }
+        out_path.push_back(a);
+        const auto middle = out_path.size();
+        for (node x = v; x != a; x = m_parent[x]) {
+            out_path.push_back(x);
+        }
+        std::reverse(out_path.begin() + middle, out_path.end());
+    }
+
+    path route(node u, node v) const
+    {
+        path result;
+        route(u, v, result);
+        return result;
+    }
+
+    friend memory_footprint memory_usage(const tree_index& x)
+    {
+        memory_footprint result = detail::vector_footprint(x.m_parent) +
+            detail::vector_footprint(x.m_root) +
+            detail::vector_footprint(x.m_depth) +
+            detail::vector_footprint(x.m_prefix) +
+            detail::vector_footprint(x.m_first);
+        memory_footprint table = detail::vector_footprint(x.m_table);
+        result.overhead += table.payload + table.overhead;
+        result.slack += table.slack;
+        for (const auto& level : x.m_table) {
+            result += detail::vector_footprint(level);
+        }
+        return result;
+    }
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <map>
 #include <array>
 #include <deque>
+#include <limits>
 #include <utility>
 #include <iterator>
 #include <algorithm>
@@ -106,6 +107,16 @@ struct array_weight {
         return x;
     }
 
+    /// The inverse of the addition; the component types are expected to form
+    /// a group, e.g. to take the differences of the prefix sums.
+    friend array_weight operator-(array_weight x, const array_weight& y)
+    {
+        for (typename decltype(x.m_impl)::size_type i = 0; i < x.m_impl.size(); ++i) {
+            x.m_impl[i] -= y.m_impl[i];
+        }
+        return x;
+    }
+
     // MultiWeight operations:
     const W& operator[](int index) const { return m_impl[index]; }
     iterator begin() { return m_impl.begin(); }
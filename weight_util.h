@@ -1,6 +1,10 @@
 #ifndef WEIGHT_UTIL_H
 #define WEIGHT_UTIL_H
 
+#include <vector>
+#include <numeric>
+#include <functional>
+
 #include "weight.h"
 
 #if 0
@@ -26,6 +30,18 @@ concept MultiWeightCmp<MultiWeight> {
 // WeightAggr
 ///////////////////////////////////////////////////////////////////////////////
 
+namespace detail {
+
+    /// A single term of a weighted sum. A zero factor yields zero even for
+    /// an infinite weight, which would otherwise turn the sum into a NaN.
+    template <Weight W>
+    W weight_aggr_term(double factor, const W& x)
+    {
+        return factor == 0.0 ? weight_traits<W>::zero() : factor * x;
+    }
+
+}
+
 template <MultiWeight MW>
 struct weight_aggr_lincmb {
     std::vector<double> m_factors;
@@ -38,7 +54,9 @@ struct weight_aggr_lincmb {
         return std::inner_product(
             begin(m_factors), end(m_factors),
             begin(mw),
-            weight_traits<W>::zero());
+            weight_traits<W>::zero(),
+            std::plus<W> {},
+            detail::weight_aggr_term<W>);
     }
 };
 
@@ -48,11 +66,15 @@ struct weight_aggr_lagrange {
     using W = typename MW::weight_type;
     W operator()(const MW &mw) const
     {
+        using std::begin;
+        using std::end;
         assert(MW::weight_count == m_factors.size() + 1);
         return std::inner_product(
             begin(m_factors), end(m_factors),
             begin(mw) + 1,
-            mw[0]);
+            mw[0],
+            std::plus<W> {},
+            detail::weight_aggr_term<W>);
     }
 };
 